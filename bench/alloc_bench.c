@@ -0,0 +1,713 @@
+//Allocator benchmark: replays allocation traces recorded from the kit loaders and synthetic
+//churn patterns against every allocator, single and multi threaded.
+//
+//    sh ./build.bat bench/alloc_bench.c
+//    ./bench/alloc_bench [model.m3d] [image.qoi] [threads]
+//
+//Defaults to assets/cesium_man.m3d, a generated 1024x1024 image and 4 threads.
+
+#include "../kit/kit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+#define BENCH_ROUNDS 8
+#define BENCH_MAX_THREADS 32
+
+//--PLATFORM--------------------------------------------------------
+
+static uint64_t _now_ns(void) {
+#if defined(_WIN32)
+	static LARGE_INTEGER freq;
+	if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+//on linux the high water mark can be reset between runs, elsewhere it is the process peak
+static void _peak_rss_reset(void) {
+#if defined(__linux__)
+	FILE* f = fopen("/proc/self/clear_refs", "w");
+	if (f) {
+		fputs("5", f);
+		fclose(f);
+	}
+#endif
+}
+
+static size_t _peak_rss_kb(void) {
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize / 1024;
+	return 0;
+#else
+#if defined(__linux__)
+	FILE* f = fopen("/proc/self/status", "r");
+	if (f) {
+		char line[256];
+		size_t kb = 0;
+		while (fgets(line, sizeof(line), f)) {
+			if (sscanf(line, "VmHWM: %zu kB", &kb) == 1) break;
+		}
+		fclose(f);
+		if (kb) return kb;
+	}
+#endif
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+	return (size_t)ru.ru_maxrss / 1024;
+#else
+	return (size_t)ru.ru_maxrss;
+#endif
+#endif
+}
+
+typedef void (*thread_fn)(void* arg);
+
+typedef struct thread_start {
+	thread_fn fn;
+	void* arg;
+} thread_start;
+
+#if defined(_WIN32)
+static DWORD WINAPI _thread_main(LPVOID p) {
+	thread_start* start = (thread_start*)p;
+	start->fn(start->arg);
+	return 0;
+}
+#else
+static void* _thread_main(void* p) {
+	thread_start* start = (thread_start*)p;
+	start->fn(start->arg);
+	return NULL;
+}
+#endif
+
+static void _run_threads(thread_fn fn, void* args, size_t arg_size, int count) {
+	thread_start starts[BENCH_MAX_THREADS];
+#if defined(_WIN32)
+	HANDLE threads[BENCH_MAX_THREADS];
+	for (int i = 0; i < count; i++) {
+		starts[i] = (thread_start){fn, (char*)args + i * arg_size};
+		threads[i] = CreateThread(NULL, 0, _thread_main, &starts[i], 0, NULL);
+	}
+	WaitForMultipleObjects((DWORD)count, threads, TRUE, INFINITE);
+	for (int i = 0; i < count; i++) CloseHandle(threads[i]);
+#else
+	pthread_t threads[BENCH_MAX_THREADS];
+	for (int i = 0; i < count; i++) {
+		starts[i] = (thread_start){fn, (char*)args + i * arg_size};
+		pthread_create(&threads[i], NULL, _thread_main, &starts[i]);
+	}
+	for (int i = 0; i < count; i++) pthread_join(threads[i], NULL);
+#endif
+}
+
+//--TRACES----------------------------------------------------------
+
+typedef enum {
+	OP_ALLOC,
+	OP_REALLOC,
+	OP_FREE,
+	OP_ALLOC_ALIGNED,
+	OP_FREE_ALIGNED,
+} op_type;
+
+typedef struct trace_op {
+	uint32_t type;
+	uint32_t slot;
+	uint32_t size;
+	uint32_t align;
+} trace_op;
+
+typedef struct trace {
+	const char* name;
+	trace_op* ops;
+	int op_count;
+	int op_capacity;
+	int slot_count;
+	uint32_t max_size;
+	bool needs_reuse; //only stays bounded if freed and reallocated memory is reused
+	size_t live;
+	size_t peak_live;
+	//slots are reused once freed so replays only need slot_count pointers
+	uint32_t* free_slots;
+	int free_slot_count;
+	uint32_t* slot_sizes;
+} trace;
+
+static void _trace_push(trace* t, op_type type, uint32_t slot, size_t size, size_t align) {
+	if (t->op_count == t->op_capacity) {
+		t->op_capacity = t->op_capacity ? t->op_capacity * 2 : 1024;
+		t->ops = (trace_op*)realloc(t->ops, t->op_capacity * sizeof(trace_op));
+	}
+	t->ops[t->op_count++] = (trace_op){type, slot, (uint32_t)size, (uint32_t)align};
+
+	if (type == OP_ALLOC || type == OP_ALLOC_ALIGNED || type == OP_REALLOC) {
+		if (type == OP_REALLOC) t->live -= t->slot_sizes[slot];
+		t->slot_sizes[slot] = (uint32_t)size;
+		t->live += size;
+		if (size > t->max_size) t->max_size = (uint32_t)size;
+		if (t->live > t->peak_live) t->peak_live = t->live;
+	} else {
+		t->live -= t->slot_sizes[slot];
+		t->slot_sizes[slot] = 0;
+	}
+}
+
+static uint32_t _trace_take_slot(trace* t) {
+	if (t->free_slot_count) return t->free_slots[--t->free_slot_count];
+	uint32_t slot = (uint32_t)t->slot_count++;
+	t->slot_sizes = (uint32_t*)realloc(t->slot_sizes, t->slot_count * sizeof(uint32_t));
+	t->free_slots = (uint32_t*)realloc(t->free_slots, t->slot_count * sizeof(uint32_t));
+	t->slot_sizes[slot] = 0;
+	return slot;
+}
+
+static void _trace_give_slot(trace* t, uint32_t slot) {
+	t->free_slots[t->free_slot_count++] = slot;
+}
+
+static void _release_trace(trace* t) {
+	free(t->ops);
+	free(t->free_slots);
+	free(t->slot_sizes);
+	*t = (trace){0};
+}
+
+//--RECORDER--------------------------------------------------------
+//wraps the default allocator and writes every call into a trace, the slot is kept in a header
+
+typedef struct record_header {
+	uint32_t slot;
+	uint32_t align;
+	uint64_t pad;
+} record_header;
+
+typedef struct recorder {
+	kit_allocator parent;
+	trace* trace;
+} recorder;
+
+static void* _record_alloc(size_t size, void* udata) {
+	recorder* rec = (recorder*)udata;
+	record_header* h = (record_header*)kit_alloc(&rec->parent, size + sizeof(record_header));
+	if (!h) return NULL;
+	h->slot = _trace_take_slot(rec->trace);
+	h->align = 0;
+	_trace_push(rec->trace, OP_ALLOC, h->slot, size, 0);
+	return h + 1;
+}
+
+static void* _record_realloc(void* ptr, size_t size, void* udata) {
+	recorder* rec = (recorder*)udata;
+	if (!ptr) return _record_alloc(size, udata);
+	record_header* h = (record_header*)kit_realloc(&rec->parent, (record_header*)ptr - 1, size + sizeof(record_header));
+	if (!h) return NULL;
+	_trace_push(rec->trace, OP_REALLOC, h->slot, size, 0);
+	return h + 1;
+}
+
+static void _record_free(void* ptr, void* udata) {
+	recorder* rec = (recorder*)udata;
+	if (!ptr) return;
+	record_header* h = (record_header*)ptr - 1;
+	_trace_push(rec->trace, OP_FREE, h->slot, 0, 0);
+	_trace_give_slot(rec->trace, h->slot);
+	kit_free(&rec->parent, h);
+}
+
+static void* _record_alloc_aligned(size_t size, size_t align, void* udata) {
+	recorder* rec = (recorder*)udata;
+	size_t pad = align < sizeof(record_header) ? sizeof(record_header) : align;
+	char* raw = (char*)kit_alloc_aligned(&rec->parent, size + pad, pad);
+	if (!raw) return NULL;
+	record_header* h = (record_header*)(raw + pad) - 1;
+	h->slot = _trace_take_slot(rec->trace);
+	h->align = (uint32_t)pad;
+	_trace_push(rec->trace, OP_ALLOC_ALIGNED, h->slot, size, align);
+	return raw + pad;
+}
+
+static void _record_free_aligned(void* ptr, void* udata) {
+	recorder* rec = (recorder*)udata;
+	if (!ptr) return;
+	record_header* h = (record_header*)ptr - 1;
+	_trace_push(rec->trace, OP_FREE_ALIGNED, h->slot, 0, 0);
+	_trace_give_slot(rec->trace, h->slot);
+	kit_free_aligned(&rec->parent, (char*)ptr - h->align);
+}
+
+static kit_allocator _recorder(recorder* rec, trace* t, const char* name) {
+	t->name = name;
+	rec->parent = kit_default_allocator();
+	rec->trace = t;
+	return (kit_allocator){
+		.udata = rec,
+		.alloc = _record_alloc,
+		.realloc = _record_realloc,
+		.free = _record_free,
+		.alloc_aligned = _record_alloc_aligned,
+		.free_aligned = _record_free_aligned,
+	};
+}
+
+//--LOADER TRACES---------------------------------------------------
+//mesh import stops at the parsed m3d data, building the vertex buffers needs a bgfx context
+
+static bool _record_mesh(trace* t, const char* path) {
+	recorder rec;
+	kit_allocator alloc = _recorder(&rec, t, "mesh import");
+	kit_file_error err = KIT_FILE_ERROR_NONE;
+	kit_m3d_data* m3d = kit_load_m3d_data(&alloc, path, &err);
+	if (!m3d) return false;
+	kit_release_m3d_data(&alloc, m3d);
+	return true;
+}
+
+static bool _record_anim(trace* t, const char* path) {
+	kit_allocator def = kit_default_allocator();
+	kit_file_error err = KIT_FILE_ERROR_NONE;
+	kit_m3d_data* m3d = kit_load_m3d_data(&def, path, &err);
+	if (!m3d) return false;
+
+	recorder rec;
+	kit_allocator alloc = _recorder(&rec, t, "anim import");
+	kit_skeleton skeleton = {0};
+	int anim_count = 0;
+	bool ok = kit_load_skeleton(&alloc, &skeleton, m3d);
+	kit_bone_anim_data* anims = kit_load_bone_anims(&alloc, m3d, &anim_count);
+	for (int i = 0; i < anim_count; i++) {
+		kit_release_bone_anim(&alloc, &anims[i]);
+	}
+	if (anims) kit_free(&alloc, anims);
+	if (ok) kit_release_skeleton(&alloc, &skeleton);
+
+	kit_release_m3d_data(&def, m3d);
+	return ok;
+}
+
+//writes an uncompressed qoi (one QOI_OP_RGB per pixel) so the decoder has real work without an asset
+static kit_memory _make_qoi(uint32_t width, uint32_t height) {
+	size_t size = 14 + (size_t)width * height * 4 + 8;
+	uint8_t* p = (uint8_t*)malloc(size);
+	uint8_t* o = p;
+	memcpy(o, "qoif", 4); o += 4;
+	*o++ = (uint8_t)(width >> 24); *o++ = (uint8_t)(width >> 16); *o++ = (uint8_t)(width >> 8); *o++ = (uint8_t)width;
+	*o++ = (uint8_t)(height >> 24); *o++ = (uint8_t)(height >> 16); *o++ = (uint8_t)(height >> 8); *o++ = (uint8_t)height;
+	*o++ = 3;
+	*o++ = 0;
+	uint32_t seed = 1;
+	for (uint32_t i = 0; i < width * height; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		*o++ = 0xfe;
+		*o++ = (uint8_t)(seed >> 24);
+		*o++ = (uint8_t)(seed >> 16);
+		*o++ = (uint8_t)(seed >> 8);
+	}
+	memset(o, 0, 7);
+	o[7] = 1;
+	return (kit_memory){p, size};
+}
+
+static bool _record_image(trace* t, const char* path) {
+	kit_allocator def = kit_default_allocator();
+	kit_memory mem = {0};
+	if (path) {
+		kit_file_error err = KIT_FILE_ERROR_NONE;
+		mem = kit_read_file(&def, path, false, &err);
+		if (!mem.ptr) return false;
+	} else {
+		mem = _make_qoi(1024, 1024);
+	}
+
+	recorder rec;
+	kit_allocator alloc = _recorder(&rec, t, "image decode");
+	kit_image_data img = kit_load_image_data_mem(&alloc, &mem, 4);
+	bool ok = img.data != NULL;
+	kit_release_image_data(&alloc, &img);
+
+	if (path) kit_free_sized(&def, mem.ptr, mem.size + 1);
+	else free(mem.ptr);
+	return ok;
+}
+
+//--SYNTHETIC TRACES------------------------------------------------
+
+static uint32_t _rand(uint32_t* state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+//mostly small objects with a long tail, roughly what the loaders produce
+static uint32_t _rand_size(uint32_t* state) {
+	uint32_t r = _rand(state) % 100;
+	if (r < 70) return 16 + _rand(state) % 112;
+	if (r < 95) return 128 + _rand(state) % 896;
+	return 1024 + _rand(state) % 15360;
+}
+
+typedef enum {
+	CHURN_FIFO,
+	CHURN_LIFO,
+	CHURN_RANDOM,
+	CHURN_FIXED,
+	CHURN_REALLOC,
+} churn_pattern;
+
+static void _make_churn(trace* t, const char* name, churn_pattern pattern, int count) {
+	*t = (trace){.name = name, .needs_reuse = pattern == CHURN_REALLOC};
+	uint32_t seed = 0x9e3779b9u;
+	enum { WINDOW = 1024 };
+	uint32_t live[WINDOW];
+	int live_count = 0;
+	int head = 0;
+
+	for (int i = 0; i < count; i++) {
+		switch (pattern) {
+		case CHURN_FIFO:
+			//allocate in order, free the oldest once the window is full
+			if (live_count == WINDOW) {
+				_trace_push(t, OP_FREE, live[head], 0, 0);
+				_trace_give_slot(t, live[head]);
+				head = (head + 1) % WINDOW;
+				live_count--;
+			}
+			live[(head + live_count++) % WINDOW] = _trace_take_slot(t);
+			_trace_push(t, OP_ALLOC, live[(head + live_count - 1) % WINDOW], _rand_size(&seed), 0);
+			break;
+		case CHURN_LIFO:
+			//stack of random depth, like nested temporaries
+			if (live_count == WINDOW || (live_count && _rand(&seed) % 2)) {
+				int pops = 1 + _rand(&seed) % live_count;
+				while (pops--) {
+					uint32_t slot = live[--live_count];
+					_trace_push(t, OP_FREE, slot, 0, 0);
+					_trace_give_slot(t, slot);
+				}
+			}
+			live[live_count] = _trace_take_slot(t);
+			_trace_push(t, OP_ALLOC, live[live_count++], _rand_size(&seed), 0);
+			break;
+		case CHURN_RANDOM:
+		case CHURN_FIXED:
+			//replace a random live object
+			if (live_count == WINDOW) {
+				int idx = _rand(&seed) % WINDOW;
+				_trace_push(t, OP_FREE, live[idx], 0, 0);
+				_trace_give_slot(t, live[idx]);
+				live[idx] = live[--live_count];
+			}
+			live[live_count] = _trace_take_slot(t);
+			_trace_push(t, OP_ALLOC, live[live_count++], pattern == CHURN_FIXED ? 64 : _rand_size(&seed), 0);
+			break;
+		case CHURN_REALLOC:
+			//interleaved growing arrays, freed once they reach 64 KB
+			if (live_count < 64) {
+				live[live_count] = _trace_take_slot(t);
+				_trace_push(t, OP_ALLOC, live[live_count++], 64, 0);
+			} else {
+				int idx = _rand(&seed) % live_count;
+				uint32_t size = t->slot_sizes[live[idx]] * 2;
+				if (size > 64 * 1024) {
+					_trace_push(t, OP_FREE, live[idx], 0, 0);
+					_trace_give_slot(t, live[idx]);
+					live[idx] = live[--live_count];
+				} else {
+					_trace_push(t, OP_REALLOC, live[idx], size, 0);
+				}
+			}
+			break;
+		}
+	}
+	while (live_count) {
+		uint32_t slot = live[--live_count];
+		_trace_push(t, OP_FREE, slot, 0, 0);
+		_trace_give_slot(t, slot);
+	}
+}
+
+//--ALLOCATORS------------------------------------------------------
+
+typedef enum {
+	FOOTPRINT_PARENT, //peak bytes taken from the parent allocator
+	FOOTPRINT_ARENA,  //committed bytes of an arena that maps its own memory
+	FOOTPRINT_NONE,
+} footprint_source;
+
+typedef struct bench_allocator {
+	const char* name;
+	kit_allocator (*make)(kit_allocator* parent);
+	void (*release)(kit_allocator* alloc);
+	uint32_t max_size; //largest request the allocator can serve, 0 for any
+	bool shared;       //thread safe, one instance is used by all threads
+	bool reuses;       //free and realloc give memory back before free_all
+	footprint_source footprint;
+} bench_allocator;
+
+static kit_allocator _make_default(kit_allocator* parent) { (void)parent; return kit_default_allocator(); }
+static kit_allocator _make_arena(kit_allocator* parent) { return kit_arena_allocator(parent, 1024 * 1024, 0); }
+static kit_allocator _make_vm_arena(kit_allocator* parent) { (void)parent; return kit_vm_arena_allocator(0, 0); }
+static kit_allocator _make_atomic_arena(kit_allocator* parent) { return kit_atomic_arena_allocator(parent, 1024 * 1024, 0, 64 * 1024); }
+static kit_allocator _make_pool(kit_allocator* parent) { return kit_pool_allocator(parent, 64, 1024); }
+static kit_allocator _make_tlsf(kit_allocator* parent) { return kit_tlsf_allocator(parent, 0); }
+static kit_allocator _make_slab(kit_allocator* parent) { return kit_slab_allocator(parent); }
+static kit_allocator _make_tracking(kit_allocator* parent) { return kit_tracking_allocator(parent); }
+static void _release_default(kit_allocator* alloc) { (void)alloc; }
+
+static const bench_allocator _allocators[] = {
+	{"default", _make_default, _release_default, 0, true, true, FOOTPRINT_NONE},
+	{"arena", _make_arena, kit_release_arena, 0, false, false, FOOTPRINT_PARENT},
+	{"vm arena", _make_vm_arena, kit_release_arena, 0, false, false, FOOTPRINT_ARENA},
+	{"atomic arena", _make_atomic_arena, kit_release_atomic_arena, 0, true, false, FOOTPRINT_PARENT},
+	{"pool(64)", _make_pool, kit_release_pool, 64, false, true, FOOTPRINT_PARENT},
+	{"tlsf", _make_tlsf, kit_release_tlsf, 0, false, true, FOOTPRINT_PARENT},
+	{"slab", _make_slab, kit_release_slab, 0, false, true, FOOTPRINT_PARENT},
+	{"tracking", _make_tracking, kit_release_tracking, 0, false, true, FOOTPRINT_PARENT},
+};
+
+//--REPLAY----------------------------------------------------------
+
+typedef struct replay_ctx {
+	const trace* trace;
+	kit_allocator* alloc;
+	void** slots;
+	uint32_t* latencies; //per op in ns when timing, NULL for throughput rounds
+	uint64_t elapsed;
+	bool failed;
+} replay_ctx;
+
+static inline void _replay_op(kit_allocator* alloc, void** slots, const trace_op* op, bool* failed) {
+	void** slot = &slots[op->slot];
+	switch (op->type) {
+	case OP_ALLOC:
+		*slot = kit_alloc(alloc, op->size);
+		break;
+	case OP_REALLOC:
+		*slot = kit_realloc(alloc, *slot, op->size);
+		break;
+	case OP_FREE:
+		kit_free(alloc, *slot);
+		*slot = NULL;
+		return;
+	case OP_ALLOC_ALIGNED:
+		*slot = kit_alloc_aligned(alloc, op->size, op->align);
+		break;
+	case OP_FREE_ALIGNED:
+		kit_free_aligned(alloc, *slot);
+		*slot = NULL;
+		return;
+	}
+	if (!*slot) {
+		*failed = true;
+		return;
+	}
+	//touch both ends so untouched pages don't flatter the allocator
+	((volatile char*)*slot)[0] = 1;
+	((volatile char*)*slot)[op->size - 1] = 1;
+}
+
+static void _replay(void* arg) {
+	replay_ctx* ctx = (replay_ctx*)arg;
+	const trace* t = ctx->trace;
+	bool failed = false;
+
+	uint64_t start = _now_ns();
+	if (ctx->latencies) {
+		for (int i = 0; i < t->op_count && !failed; i++) {
+			uint64_t op_start = _now_ns();
+			_replay_op(ctx->alloc, ctx->slots, &t->ops[i], &failed);
+			ctx->latencies[i] = (uint32_t)(_now_ns() - op_start);
+		}
+	} else {
+		for (int i = 0; i < t->op_count && !failed; i++) {
+			_replay_op(ctx->alloc, ctx->slots, &t->ops[i], &failed);
+		}
+	}
+	ctx->elapsed = _now_ns() - start;
+	ctx->failed = failed;
+
+	//a failed replay leaves allocations behind, they go with free_all or the release
+	if (failed) memset(ctx->slots, 0, t->slot_count * sizeof(void*));
+}
+
+static int _cmp_u32(const void* a, const void* b) {
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+static uint32_t _timer_overhead;
+
+static void _calibrate_timer(void) {
+	uint32_t samples[1001];
+	for (int i = 0; i < 1001; i++) {
+		uint64_t a = _now_ns();
+		samples[i] = (uint32_t)(_now_ns() - a);
+	}
+	qsort(samples, 1001, sizeof(uint32_t), _cmp_u32);
+	_timer_overhead = samples[500];
+}
+
+static uint32_t _percentile(uint32_t* sorted, size_t count, double p) {
+	uint32_t v = sorted[(size_t)((double)(count - 1) * p)];
+	return v > _timer_overhead ? v - _timer_overhead : 0;
+}
+
+static void _bench(const trace* t, const bench_allocator* ba, int thread_count) {
+	if (ba->max_size && t->max_size > ba->max_size) return;
+	//every grown array would be copied and kept until free_all, gigabytes per thread and round
+	if (t->needs_reuse && !ba->reuses) {
+		printf("%-14s %-14s %2d  n/a\n", t->name, ba->name, thread_count);
+		return;
+	}
+
+	//footprint is what the allocator takes from its parent, only measured single threaded since tracking isn't thread safe
+	kit_allocator def = kit_default_allocator();
+	kit_allocator tracker = thread_count == 1 ? kit_tracking_allocator(&def) : def;
+
+	kit_allocator instances[BENCH_MAX_THREADS];
+	int instance_count = ba->shared ? 1 : thread_count;
+	for (int i = 0; i < instance_count; i++) {
+		instances[i] = ba->make(&tracker);
+	}
+
+	replay_ctx ctx[BENCH_MAX_THREADS];
+	void** slots = (void**)calloc((size_t)thread_count * t->slot_count, sizeof(void*));
+	uint32_t* latencies = (uint32_t*)malloc((size_t)thread_count * t->op_count * sizeof(uint32_t));
+	for (int i = 0; i < thread_count; i++) {
+		ctx[i] = (replay_ctx){
+			.trace = t,
+			.alloc = &instances[ba->shared ? 0 : i],
+			.slots = slots + (size_t)i * t->slot_count,
+		};
+	}
+
+	_peak_rss_reset();
+	uint64_t total_ns = 0;
+	bool failed = false;
+	//round 0 warms up, the last round is timed per op
+	for (int round = 0; round <= BENCH_ROUNDS + 1; round++) {
+		bool timed = round == BENCH_ROUNDS + 1;
+		for (int i = 0; i < thread_count; i++) {
+			ctx[i].latencies = timed ? latencies + (size_t)i * t->op_count : NULL;
+		}
+		_run_threads(_replay, ctx, sizeof(replay_ctx), thread_count);
+
+		uint64_t round_ns = 0;
+		for (int i = 0; i < thread_count; i++) {
+			if (ctx[i].elapsed > round_ns) round_ns = ctx[i].elapsed;
+			failed |= ctx[i].failed;
+		}
+		if (round > 0 && !timed) total_ns += round_ns;
+		//arenas only give memory back here, like they would between loads
+		for (int i = 0; i < instance_count; i++) {
+			kit_free_all(&instances[i]);
+		}
+		if (failed) break;
+	}
+	size_t peak_rss = _peak_rss_kb();
+
+	size_t footprint = 0;
+	if (thread_count == 1) {
+		if (ba->footprint == FOOTPRINT_ARENA) footprint = kit_arena_get_stats(&instances[0]).reserved;
+		else if (ba->footprint == FOOTPRINT_PARENT) footprint = kit_tracking_get_total(&tracker).peak_bytes;
+	}
+
+	for (int i = 0; i < instance_count; i++) {
+		ba->release(&instances[i]);
+	}
+	if (thread_count == 1) {
+		kit_log_set_quiet(true);
+		kit_release_tracking(&tracker);
+		kit_log_set_quiet(false);
+	}
+
+	if (failed) {
+		printf("%-14s %-14s %2d  failed\n", t->name, ba->name, thread_count);
+	} else {
+		size_t lat_count = (size_t)thread_count * t->op_count;
+		qsort(latencies, lat_count, sizeof(uint32_t), _cmp_u32);
+		double mops = (double)t->op_count * thread_count * BENCH_ROUNDS / ((double)total_ns / 1e9) / 1e6;
+
+		char frag[16] = "-";
+		char foot[24] = "-";
+		if (footprint) {
+			snprintf(frag, sizeof(frag), "%.1f%%", 100.0 * (1.0 - (double)t->peak_live / (double)footprint));
+			snprintf(foot, sizeof(foot), "%zu", footprint / 1024);
+		}
+
+		printf("%-14s %-14s %2d %9.2f %8u %8u %10zu %10s %10zu %8s\n",
+			t->name, ba->name, thread_count, mops,
+			_percentile(latencies, lat_count, 0.5), _percentile(latencies, lat_count, 0.99),
+			t->peak_live / 1024, foot, peak_rss, frag);
+	}
+	fflush(stdout);
+
+	free(slots);
+	free(latencies);
+}
+
+int main(int argc, char** argv) {
+	const char* model_path = argc > 1 ? argv[1] : "assets/cesium_man.m3d";
+	const char* image_path = argc > 2 ? argv[2] : NULL;
+	int thread_count = argc > 3 ? atoi(argv[3]) : 4;
+	if (thread_count < 1) thread_count = 1;
+	if (thread_count > BENCH_MAX_THREADS) thread_count = BENCH_MAX_THREADS;
+
+	kit_log_set_level(KIT_LOG_WARN);
+	_calibrate_timer();
+
+	trace traces[8];
+	int trace_count = 0;
+	if (_record_mesh(&traces[trace_count], model_path)) trace_count++;
+	else kit_log_error("Failed to record mesh import from %s", model_path);
+	if (_record_anim(&traces[trace_count], model_path)) trace_count++;
+	else kit_log_error("Failed to record anim import from %s", model_path);
+	if (_record_image(&traces[trace_count], image_path)) trace_count++;
+	else kit_log_error("Failed to record image decode");
+	_make_churn(&traces[trace_count++], "churn fifo", CHURN_FIFO, 100000);
+	_make_churn(&traces[trace_count++], "churn lifo", CHURN_LIFO, 100000);
+	_make_churn(&traces[trace_count++], "churn random", CHURN_RANDOM, 100000);
+	_make_churn(&traces[trace_count++], "churn fixed64", CHURN_FIXED, 100000);
+	_make_churn(&traces[trace_count++], "churn realloc", CHURN_REALLOC, 100000);
+
+	printf("timer overhead %u ns (subtracted from latencies), %d rounds per run\n", _timer_overhead, BENCH_ROUNDS);
+	printf("peak live/footprint/rss in KB, fragmentation is 1 - peak live / footprint\n\n");
+	printf("%-14s %-14s %2s %9s %8s %8s %10s %10s %10s %8s\n",
+		"workload", "allocator", "th", "Mops/s", "p50 ns", "p99 ns", "peak live", "footprint", "peak rss", "frag");
+
+	int thread_counts[2] = {1, thread_count};
+	for (int tc = 0; tc < (thread_count > 1 ? 2 : 1); tc++) {
+		for (int t = 0; t < trace_count; t++) {
+			for (int a = 0; a < (int)(sizeof(_allocators) / sizeof(_allocators[0])); a++) {
+				_bench(&traces[t], &_allocators[a], thread_counts[tc]);
+			}
+		}
+		printf("\n");
+	}
+
+	for (int t = 0; t < trace_count; t++) {
+		_release_trace(&traces[t]);
+	}
+	return 0;
+}
@@ -43,7 +43,7 @@ int main() {
 	bgfx_set_debug(BGFX_DEBUG_TEXT);
 
 	kit_allocator alloc = kit_default_allocator();
-	kit_allocator arena = kit_arena_allocator(&alloc, 10 * 1024 * 1024, 16);
+	kit_allocator arena = kit_arena_allocator(&alloc, 1024 * 1024, 16);
 
 	kit_file_error err = KIT_FILE_ERROR_NONE;
 
@@ -77,7 +77,7 @@ int main() {
 		.loop = true
 	};
 
-	kit_release_m3d_data(m3d);
+	kit_release_m3d_data(&arena, m3d);
 
 	kit_cam cam = {0};
 	kit_init_cam(&cam, &(kit_cam_desc) {
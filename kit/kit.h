@@ -11,6 +11,7 @@ extern "C" {
 #include "deps/hmm.h"
 #include "deps/bgfx/bgfx.h"
 #include <stdbool.h>
+#include <stdio.h>
 
 #ifndef KIT_ASSERT
 #include <assert.h>
@@ -29,6 +30,15 @@ extern "C" {
 
 #define KIT_DEF(val, def) (val == 0 ? def : val)
 
+//alignment of pose buffers and other data read with SIMD loads
+#define KIT_SIMD_ALIGN 16
+
+#if defined(_MSC_VER)
+#define KIT_THREAD_LOCAL __declspec(thread)
+#else
+#define KIT_THREAD_LOCAL _Thread_local
+#endif
+
 typedef struct kit_memory {
 	uint8_t* ptr;
 	size_t size;
@@ -45,32 +55,169 @@ typedef struct kit_memory {
 typedef void* (*kit_alloc_fn)(size_t size, void* udata);
 typedef void* (*kit_realloc_fn)(void* ptr, size_t size, void* udata);
 typedef void  (*kit_free_fn)(void* ptr, void* udata);
+typedef void* (*kit_alloc_aligned_fn)(size_t size, size_t align, void* udata);
+typedef void  (*kit_free_sized_fn)(void* ptr, size_t size, void* udata);
+typedef void  (*kit_free_all_fn)(void* udata);
 
 typedef struct kit_allocator {
 	void* udata;
 	kit_alloc_fn alloc;
 	kit_realloc_fn realloc;
 	kit_free_fn free;
+	kit_alloc_aligned_fn alloc_aligned; //optional, kit_alloc_aligned over-allocates through alloc if NULL
+	kit_free_fn free_aligned;           //must be set if alloc_aligned is
+	kit_free_sized_fn free_sized;       //optional, size is the size passed to alloc/realloc
+	kit_free_all_fn free_all;           //optional, releases every allocation at once
 } kit_allocator;
 
 void* kit_alloc(kit_allocator* alloc, size_t size);
 void* kit_realloc(kit_allocator* alloc, void* ptr, size_t size);
 void kit_free(kit_allocator* alloc, void* ptr);
+//falls back to kit_free if the allocator has no free_sized
+void kit_free_sized(kit_allocator* alloc, void* ptr, size_t size);
+//returns false if the allocator can't free everything at once
+bool kit_free_all(kit_allocator* alloc);
+//align must be a power of two. Aligned blocks must be released with kit_free_aligned and can't be reallocated.
+void* kit_alloc_aligned(kit_allocator* alloc, size_t size, size_t align);
+void kit_free_aligned(kit_allocator* alloc, void* ptr);
 
 kit_allocator kit_default_allocator(void);
 
+typedef struct kit_arena_stats {
+	size_t used;     //bytes handed out since the last reset, including alignment padding
+	size_t peak;     //highest value of used over the arena's lifetime
+	size_t reserved; //bytes currently held from the parent allocator
+	int block_count;
+} kit_arena_stats;
+
+//capacity is the size of the first block, further blocks are chained from alloc when it runs out.
+//realloc grows the most recent allocation in place and copies otherwise, free only reclaims the most recent allocation.
 kit_allocator kit_arena_allocator(kit_allocator* alloc, size_t capacity, size_t align);
+//keeps the largest block and returns the others to the parent allocator
 void kit_arena_reset(kit_allocator* arena);
 void kit_release_arena(kit_allocator* arena);
+kit_arena_stats kit_arena_get_stats(kit_allocator* arena);
+
+//arena over a reserved range of virtual memory (1 GB if 0), pages are committed as the arena grows.
+//pointers never move and the arena works with all kit_arena_* functions, reserved in the stats is the committed size.
+kit_allocator kit_vm_arena_allocator(size_t reserve, size_t align);
+//returns committed pages past the current offset to the OS, e.g. after a reset. No-op for block arenas.
+void kit_arena_decommit(kit_allocator* arena);
+
+typedef struct kit_arena_marker {
+	void* block;
+	size_t offset;
+	size_t used;
+} kit_arena_marker;
+
+//rewinding frees everything allocated after the marker, markers must be rewound in LIFO order
+kit_arena_marker kit_arena_mark(kit_allocator* arena);
+void kit_arena_rewind(kit_allocator* arena, kit_arena_marker marker);
+
+typedef struct kit_scratch {
+	kit_allocator* alloc;
+	kit_arena_marker marker;
+} kit_scratch;
+
+//per-thread arena for temporary memory, created on first use.
+//pairs of begin/end may nest, release frees the calling thread's arena before it exits
+kit_scratch kit_scratch_begin(void);
+void kit_scratch_end(kit_scratch* scratch);
+void kit_release_scratch(void);
+
+//arena that can be shared by threads, the offset is bumped with compare-and-swap.
+//thread_cache > 0 lets each thread grab sub-blocks of that size and serve small allocations from them without atomics.
+//alloc must be thread safe, reset and release must not overlap with allocations.
+kit_allocator kit_atomic_arena_allocator(kit_allocator* alloc, size_t capacity, size_t align, size_t thread_cache);
+void kit_atomic_arena_reset(kit_allocator* arena);
+void kit_release_atomic_arena(kit_allocator* arena);
+
+//ring of buffer_count (2 if 0, at most 4) arenas for data handed to bgfx by reference.
+//advancing with the number returned by bgfx_frame recycles the buffer bgfx is done with.
+kit_allocator kit_frame_allocator(kit_allocator* alloc, size_t capacity, int buffer_count);
+void kit_frame_advance(kit_allocator* frame, uint32_t frame_number);
+//calls bgfx_frame and advances the frame allocator
+uint32_t kit_frame(kit_allocator* frame, bool capture);
+//frame memory wrapped with bgfx_make_ref, fill ->data before the next kit_frame
+const bgfx_memory_t* kit_frame_ref(kit_allocator* frame, uint32_t size);
+void kit_release_frame_allocator(kit_allocator* frame);
+
+//fixed-size blocks with O(1) alloc/free, grows by count blocks at a time.
+//requests larger than block_size or aligned beyond two pointer sizes fail. Define KIT_POOL_ZERO_ON_FREE=1 to clear blocks when they are freed.
+kit_allocator kit_pool_allocator(kit_allocator* alloc, size_t block_size, size_t count);
+void kit_release_pool(kit_allocator* pool);
+
+//general purpose two-level segregated fit allocator with O(1) alloc/free and in-place realloc.
+//memory is taken from alloc in regions of at least region_size bytes (16 MB if 0).
+kit_allocator kit_tlsf_allocator(kit_allocator* alloc, size_t region_size);
+void kit_release_tlsf(kit_allocator* tlsf);
+
+//size classes from 16 to 2048 bytes served from KIT_SLAB_SIZE slabs without per-block headers.
+//slabs come from alloc in aligned chunks of 16, a chunk is returned once all its slabs are empty.
+//larger or over-aligned requests get their own block from alloc.
+kit_allocator kit_slab_allocator(kit_allocator* alloc);
+void kit_release_slab(kit_allocator* slab);
+
+#define KIT_TRACKING_HISTOGRAM_BINS 24
+
+typedef struct kit_tracking_stats {
+	const char* tag;
+	size_t live_bytes;
+	size_t peak_bytes;
+	size_t live_allocs;
+	size_t total_allocs;
+	size_t total_reallocs; //resizes of live allocations, not included in total_allocs or the histogram
+	size_t histogram[KIT_TRACKING_HISTOGRAM_BINS]; //allocations per power of two size class
+} kit_tracking_stats;
+
+//wraps alloc and records live/peak bytes per tag. Like the other allocators it is not thread safe.
+kit_allocator kit_tracking_allocator(kit_allocator* alloc);
+//returns an allocator that books into the given tag of the tracker, tag must outlive the tracker
+kit_allocator kit_tracking_tag(kit_allocator* tracker, const char* tag);
+int kit_tracking_tag_count(kit_allocator* tracker);
+kit_tracking_stats kit_tracking_get_stats(kit_allocator* tracker, int tag);
+kit_tracking_stats kit_tracking_get_total(kit_allocator* tracker);
+//logs totals and every tag with live allocations
+void kit_tracking_report(kit_allocator* tracker);
+//reports leaks before releasing the tracker, leaked blocks stay with the parent allocator
+void kit_release_tracking(kit_allocator* tracker);
 
 //--LOGGING---------------------------------------------------------
 // from https://github.com/rxi/log.c
 
+typedef enum kit_log_field_type {
+	KIT_LOG_FIELD_INT,
+	KIT_LOG_FIELD_FLOAT,
+	KIT_LOG_FIELD_BOOL,
+	KIT_LOG_FIELD_STRING,
+} kit_log_field_type;
+
+typedef struct kit_log_field {
+	const char* key;
+	kit_log_field_type type;
+	union {
+		int64_t i;
+		double f;
+		bool b;
+		const char* s;
+	};
+} kit_log_field;
+
+#define KIT_LOG_INT(k, v)   ((kit_log_field){ .key = (k), .type = KIT_LOG_FIELD_INT, .i = (int64_t)(v) })
+#define KIT_LOG_FLOAT(k, v) ((kit_log_field){ .key = (k), .type = KIT_LOG_FIELD_FLOAT, .f = (double)(v) })
+#define KIT_LOG_BOOL(k, v)  ((kit_log_field){ .key = (k), .type = KIT_LOG_FIELD_BOOL, .b = (v) })
+#define KIT_LOG_STR(k, v)   ((kit_log_field){ .key = (k), .type = KIT_LOG_FIELD_STRING, .s = (v) })
+
 typedef struct kit_log_event {
 	va_list ap;
 	const char *fmt;
 	const char *file;
 	struct tm *time;
+	const char *timestamp; //time as "YYYY-mm-dd HH:MM:SS", formatted once per second
+	uint64_t time_ns;      //monotonic nanoseconds since the logger started, see kit_log_time_ns
+	uint64_t seq;          //global message order across threads
+	const kit_log_field* fields; //set for messages from kit_log_kv
+	int field_count;
 	void *udata;
 	int line;
 	int level;
@@ -88,12 +235,49 @@ typedef enum {
 	KIT_LOG_FATAL
 } kit_log_level;
 
-#define kit_log_trace(...) kit_log(KIT_LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
-#define kit_log_debug(...) kit_log(KIT_LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
-#define kit_log_info(...)  kit_log(KIT_LOG_INFO,  __FILE__, __LINE__, __VA_ARGS__)
-#define kit_log_warn(...)  kit_log(KIT_LOG_WARN,  __FILE__, __LINE__, __VA_ARGS__)
-#define kit_log_error(...) kit_log(KIT_LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
-#define kit_log_fatal(...) kit_log(KIT_LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
+//macros below KIT_LOG_MIN_LEVEL (0 = TRACE ... 5 = FATAL) compile to nothing and don't evaluate their arguments
+#ifndef KIT_LOG_MIN_LEVEL
+#define KIT_LOG_MIN_LEVEL 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define KIT_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define KIT_UNLIKELY(x) (x)
+#endif
+
+//lowest level any sink accepts, checked before calling kit_log
+extern int _kit_log_min_level;
+
+#define _KIT_LOG_ON(level, ...)  (KIT_UNLIKELY((level) >= _kit_log_min_level) ? kit_log(level, __FILE__, __LINE__, __VA_ARGS__) : (void)0)
+#define _KIT_LOG_OFF(level, ...) (0 ? kit_log(level, __FILE__, __LINE__, __VA_ARGS__) : (void)0)
+
+#if KIT_LOG_MIN_LEVEL <= 0
+#define kit_log_trace(...) _KIT_LOG_ON(KIT_LOG_TRACE, __VA_ARGS__)
+#else
+#define kit_log_trace(...) _KIT_LOG_OFF(KIT_LOG_TRACE, __VA_ARGS__)
+#endif
+#if KIT_LOG_MIN_LEVEL <= 1
+#define kit_log_debug(...) _KIT_LOG_ON(KIT_LOG_DEBUG, __VA_ARGS__)
+#else
+#define kit_log_debug(...) _KIT_LOG_OFF(KIT_LOG_DEBUG, __VA_ARGS__)
+#endif
+#if KIT_LOG_MIN_LEVEL <= 2
+#define kit_log_info(...)  _KIT_LOG_ON(KIT_LOG_INFO, __VA_ARGS__)
+#else
+#define kit_log_info(...)  _KIT_LOG_OFF(KIT_LOG_INFO, __VA_ARGS__)
+#endif
+#if KIT_LOG_MIN_LEVEL <= 3
+#define kit_log_warn(...)  _KIT_LOG_ON(KIT_LOG_WARN, __VA_ARGS__)
+#else
+#define kit_log_warn(...)  _KIT_LOG_OFF(KIT_LOG_WARN, __VA_ARGS__)
+#endif
+#if KIT_LOG_MIN_LEVEL <= 4
+#define kit_log_error(...) _KIT_LOG_ON(KIT_LOG_ERROR, __VA_ARGS__)
+#else
+#define kit_log_error(...) _KIT_LOG_OFF(KIT_LOG_ERROR, __VA_ARGS__)
+#endif
+#define kit_log_fatal(...) _KIT_LOG_ON(KIT_LOG_FATAL, __VA_ARGS__)
 
 const char* kit_log_level_string(int level);
 void kit_log_set_lock(kit_log_lock_fn fn, void *udata);
@@ -101,9 +285,94 @@ void kit_log_set_level(kit_log_level level);
 void kit_log_set_quiet(bool enable);
 bool kit_log_add_callback(kit_log_fn fn, void *udata, kit_log_level level);
 bool kit_log_add_file(const char *path, kit_log_level level);
+//one json object per line, written through a 64 KB buffer that is flushed on ERROR and FATAL and by kit_log_flush
+bool kit_log_add_json(const char* path, kit_log_level level);
+//writes each line into one of slot_count fixed 512 byte slots of a memory mapped file (4096 if 0).
+//the kernel persists the pages when the process crashes, a ring left by an earlier run is continued.
+//FATAL and kit_log_flush also wait until the ring is on disk, for the case where the machine goes down.
+bool kit_log_add_ring_file(const char* path, uint32_t slot_count, kit_log_level level);
+//writes the surviving lines of a ring file in order, torn slots are skipped
+bool kit_log_render_ring_file(kit_allocator* alloc, const char* path, FILE* out);
+//prefixes stderr and file lines with the seconds since the logger started, in ns resolution
+void kit_log_set_monotonic(bool enable);
+//the clock of kit_log_event.time_ns, for correlating log lines with frame timings
+uint64_t kit_log_time_ns(void);
+
+#ifndef KIT_LOG_MESSAGE_SIZE
+#define KIT_LOG_MESSAGE_SIZE 256
+#endif
+
+typedef enum kit_log_overflow {
+	KIT_LOG_OVERFLOW_DROP,  //discard the message
+	KIT_LOG_OVERFLOW_BLOCK, //wait until the writer makes room
+	KIT_LOG_OVERFLOW_COUNT, //discard and let the writer report how many were lost
+} kit_log_overflow;
+
+typedef struct kit_log_async_desc {
+	uint32_t capacity; //messages in the ring, rounded up to a power of two (1024 if 0)
+	kit_log_overflow overflow;
+} kit_log_async_desc;
+
+//messages are formatted on the calling thread into a lock-free ring and written by a background thread.
+//callbacks then run on the writer thread and get the formatted message with fmt "%s", longer messages than KIT_LOG_MESSAGE_SIZE are cut.
+bool kit_log_start_async(kit_allocator* alloc, const kit_log_async_desc* desc);
+//blocks until everything logged before the call is written, binary and buffered thread buffers included
+void kit_log_flush(void);
+//writes what is left in the ring and joins the writer, must not overlap with logging from other threads
+void kit_log_stop_async(void);
+//messages lost to a full ring since kit_log_start_async
+uint64_t kit_log_dropped_count(void);
+
+typedef struct kit_log_binary_desc {
+	const char* path;
+	size_t buffer_size;  //per thread, written to the file when full (64 KB if 0)
+	kit_log_level level; //messages below it are discarded
+} kit_log_binary_desc;
+
+//kit_log stores the format and file pointers, line, timestamp and raw arguments in a per thread buffer instead of formatting.
+//%s arguments are copied and %n is ignored. ERROR and FATAL messages also go through the text path.
+bool kit_log_start_binary(kit_allocator* alloc, const kit_log_binary_desc* desc);
+//must not overlap with logging from other threads
+void kit_log_stop_binary(void);
+//formats a binary log back to text in the layout of kit_log_add_file, ordered by timestamp
+bool kit_log_render_binary(kit_allocator* alloc, const char* path, FILE* out);
+
+typedef struct kit_log_buffer_desc {
+	size_t size;               //per thread, written out when full (16 KB if 0)
+	uint32_t interval_ms;      //longest a line waits in a buffer (100 if 0)
+	kit_log_level flush_level; //lines at or above it are written immediately (ERROR if 0)
+} kit_log_buffer_desc;
+
+//stderr and file lines collect in per thread buffers instead of being flushed one by one.
+//lines start with "#seq", the global message order, as threads write their buffers independently. FATAL writes every buffer.
+//lines longer than 4 KB are cut and end in "[...]".
+bool kit_log_start_buffered(kit_allocator* alloc, const kit_log_buffer_desc* desc);
+//writes all buffers and stops the flusher thread, must not overlap with logging from other threads
+void kit_log_stop_buffered(void);
 
 void kit_log(kit_log_level level, const char* file, int line, const char *fmt, ...);
 
+//logs at most per_second messages per second from one call site, or only the first one if per_second is 0.
+//sites are keyed by file and line, the next message that gets through reports how many were suppressed.
+void kit_log_limited(kit_log_level level, const char* file, int line, uint32_t per_second, const char* fmt, ...);
+
+//message with typed fields, the text sinks append them as key=value and the json sink writes them as an object.
+//binary logs store the fields as text. with kit_log_start_async a message keeps at most 16 fields, which share
+//its KIT_LOG_MESSAGE_SIZE slot: string values are cut to fit and the rest is replaced by fields_dropped=N.
+void kit_log_fields(kit_log_level level, const char* file, int line, const char* msg, const kit_log_field* fields, int field_count);
+
+//kit_log_kv(KIT_LOG_INFO, "Loaded mesh", KIT_LOG_STR("path", path), KIT_LOG_INT("vertices", count))
+//the leading empty field keeps the array valid when no fields are given
+#define kit_log_kv(level, msg, ...) \
+	(KIT_UNLIKELY((level) >= _kit_log_min_level) ? kit_log_fields(level, __FILE__, __LINE__, msg, \
+		(kit_log_field[]){ {0}, __VA_ARGS__ } + 1, \
+		(int)(sizeof((kit_log_field[]){ {0}, __VA_ARGS__ }) / sizeof(kit_log_field)) - 1) : (void)0)
+
+#define kit_log_rate(level, per_second, ...) \
+	(KIT_UNLIKELY((level) >= _kit_log_min_level) ? kit_log_limited(level, __FILE__, __LINE__, per_second, __VA_ARGS__) : (void)0)
+#define kit_log_once(level, ...) \
+	(KIT_UNLIKELY((level) >= _kit_log_min_level) ? kit_log_limited(level, __FILE__, __LINE__, 0, __VA_ARGS__) : (void)0)
+
 //--INIT&SHUTDOWN--------------------------------------------------------------
 
 typedef struct kit_desc {
@@ -130,7 +399,68 @@ typedef enum kit_file_error {
 	KIT_FILE_ERROR_UNKNOWN,
 } kit_file_error;
 
+//the buffer is always allocated with one extra byte for the terminator, free it with kit_free_sized(alloc, mem.ptr, mem.size + 1)
 kit_memory kit_read_file(kit_allocator* alloc, const char* path, bool null_terminate, kit_file_error* err);
+//read-only view of the whole file without a copy or allocation, not null terminated. the path loaders use it.
+kit_memory kit_map_file(const char* path, kit_file_error* err);
+void kit_unmap_file(kit_memory* mem);
+
+typedef struct kit_file_request* kit_file_handle;
+
+typedef enum kit_file_priority {
+	KIT_FILE_PRIORITY_LOW = -1,
+	KIT_FILE_PRIORITY_NORMAL = 0,
+	KIT_FILE_PRIORITY_HIGH = 1,
+} kit_file_priority;
+
+typedef enum kit_file_status {
+	KIT_FILE_STATUS_PENDING,
+	KIT_FILE_STATUS_RUNNING,
+	KIT_FILE_STATUS_DONE,
+	KIT_FILE_STATUS_FAILED,
+	KIT_FILE_STATUS_CANCELLED,
+} kit_file_status;
+
+//runs on an io thread once the read is done or failed, not for cancelled reads. poll, wait and take see the
+//final status from here, other threads only once it returns. must not release the handle or wait on other reads.
+typedef void (*kit_file_callback)(kit_file_handle handle, void* udata);
+
+typedef enum kit_file_io_backend {
+	KIT_FILE_IO_BACKEND_AUTO,    //io_uring on linux when the kernel allows it, the thread pool otherwise
+	KIT_FILE_IO_BACKEND_THREADS,
+	KIT_FILE_IO_BACKEND_URING,   //fails to start without io_uring
+} kit_file_io_backend;
+
+typedef struct kit_file_io_desc {
+	kit_file_io_backend backend;
+	uint32_t thread_count; //reads in flight at once on the thread pool (4 if 0)
+	uint32_t queue_depth;  //reads in flight at once with io_uring, batched on one io thread (64 if 0)
+} kit_file_io_desc;
+
+typedef struct kit_file_read_desc {
+	void* udata;
+	kit_file_priority priority; //higher priorities are started first, equal ones in order
+	bool null_terminate;
+} kit_file_read_desc;
+
+//alloc is kept for the requests themselves and has to be thread safe if reads are started from several threads
+bool kit_file_io_start(kit_allocator* alloc, const kit_file_io_desc* desc);
+//cancels what has not started and joins the io threads, handles stay valid until released
+void kit_file_io_stop(void);
+//the backend that was started, AUTO if the io threads are not running
+kit_file_io_backend kit_file_io_get_backend(void);
+
+//reads the file on an io thread into memory from alloc, which is used from the io threads. desc may be NULL.
+kit_file_handle kit_read_file_async(const char* path, kit_allocator* alloc, kit_file_callback callback, const kit_file_read_desc* desc);
+kit_file_status kit_file_poll(kit_file_handle handle);
+//blocks until the read is done, failed or cancelled
+kit_file_status kit_file_wait(kit_file_handle handle);
+//true if the read will not complete, a running read stops at the next chunk
+bool kit_file_cancel(kit_file_handle handle);
+//hands the data over once the read is done, free it like the memory of kit_read_file
+kit_memory kit_file_take(kit_file_handle handle, kit_file_error* err);
+//cancels and waits for the read if needed, frees data that was not taken
+void kit_file_release(kit_file_handle handle);
 
 //--SHADER----------------------------------------------
 
@@ -155,9 +485,11 @@ void kit_release_image_data(kit_allocator* alloc, kit_image_data* img);
 
 typedef struct m3d_t kit_m3d_data;
 
+//the model and everything m3d allocates while parsing it come from alloc, release with the same allocator
 kit_m3d_data* kit_load_m3d_data(kit_allocator* alloc, const char* path, kit_file_error* err);
-kit_m3d_data* kit_load_m3d_data_mem(kit_memory* mem);
-void kit_release_m3d_data(kit_m3d_data* m3d);
+//uncompressed models point into mem, it has to outlive the model
+kit_m3d_data* kit_load_m3d_data_mem(kit_allocator* alloc, kit_memory* mem);
+void kit_release_m3d_data(kit_allocator* alloc, kit_m3d_data* m3d);
 
 typedef struct kit_vertex_pnt {
 	HMM_Vec3 pos;
@@ -1,9 +1,16 @@
 #include "kit.h"
+#include "kit_internal.h"
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 //--ALLOCATORS-------------------------------------------------------
 
+static size_t _align_forward(size_t ptr, size_t align) {
+    size_t mod = ptr % align;
+    return mod == 0 ? ptr : ptr + (align - mod);
+}
+
 void* kit_alloc(kit_allocator* alloc, size_t size) {
     if (alloc && alloc->alloc) {
         return alloc->alloc(size, alloc->udata);
@@ -24,6 +31,72 @@ void kit_free(kit_allocator* alloc, void* ptr) {
     }
 }
 
+void kit_free_sized(kit_allocator* alloc, void* ptr, size_t size) {
+    if (alloc && alloc->free_sized) {
+        alloc->free_sized(ptr, size, alloc->udata);
+        return;
+    }
+    kit_free(alloc, ptr);
+}
+
+bool kit_free_all(kit_allocator* alloc) {
+    if (alloc && alloc->free_all) {
+        alloc->free_all(alloc->udata);
+        return true;
+    }
+    return false;
+}
+
+void* kit_alloc_aligned(kit_allocator* alloc, size_t size, size_t align) {
+    if (!alloc) return NULL;
+    KIT_ASSERT(align && (align & (align - 1)) == 0);
+    if (alloc->alloc_aligned) {
+        return alloc->alloc_aligned(size, align, alloc->udata);
+    }
+    //over-allocate and keep the original pointer right in front of the aligned one
+    char* raw = (char*)kit_alloc(alloc, size + align + sizeof(void*));
+    if (!raw) return NULL;
+    void** aligned = (void**)_align_forward((size_t)raw + sizeof(void*), align);
+    aligned[-1] = raw;
+    return aligned;
+}
+
+void kit_free_aligned(kit_allocator* alloc, void* ptr) {
+    if (!alloc || !ptr) return;
+    if (alloc->free_aligned) {
+        alloc->free_aligned(ptr, alloc->udata);
+        return;
+    }
+    kit_free(alloc, ((void**)ptr)[-1]);
+}
+
+//DEPENDENCIES
+
+static KIT_THREAD_LOCAL kit_allocator* _dep_allocator;
+
+kit_allocator* _kit_push_dep_allocator(kit_allocator* alloc) {
+    kit_allocator* prev = _dep_allocator;
+    _dep_allocator = alloc;
+    return prev;
+}
+
+void _kit_pop_dep_allocator(kit_allocator* prev) {
+    _dep_allocator = prev;
+}
+
+void* _kit_dep_malloc(size_t size) {
+    return _dep_allocator ? kit_alloc(_dep_allocator, size) : malloc(size);
+}
+
+void* _kit_dep_realloc(void* ptr, size_t size) {
+    return _dep_allocator ? kit_realloc(_dep_allocator, ptr, size) : realloc(ptr, size);
+}
+
+void _kit_dep_free(void* ptr) {
+    if (_dep_allocator) kit_free(_dep_allocator, ptr);
+    else free(ptr);
+}
+
 //DEFAULTS
 
 static void* _default_alloc(size_t size, void* udata) {
@@ -36,9 +109,34 @@ static void* _default_realloc(void* ptr, size_t size, void* udata) {
     return realloc(ptr, size);
 }
 
-static void _default_free(void* udata, void* ptr) {
+static void _default_free(void* ptr, void* udata) {
+    (void)udata;
+    free(ptr);
+}
+
+static void _default_free_sized(void* ptr, size_t size, void* udata) {
+    (void)size; (void)udata;
+    free(ptr);
+}
+
+static void* _default_alloc_aligned(size_t size, size_t align, void* udata) {
+    (void)udata;
+#if defined(_WIN32)
+    return _aligned_malloc(size, align);
+#else
+    void* ptr = NULL;
+    if (align < sizeof(void*)) align = sizeof(void*);
+    return posix_memalign(&ptr, align, size) == 0 ? ptr : NULL;
+#endif
+}
+
+static void _default_free_aligned(void* ptr, void* udata) {
     (void)udata;
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
     free(ptr);
+#endif
 }
 
 kit_allocator kit_default_allocator(void) {
@@ -46,73 +144,1720 @@ kit_allocator kit_default_allocator(void) {
     alloc.alloc = _default_alloc;
     alloc.realloc = _default_realloc;
     alloc.free = _default_free;
+    alloc.alloc_aligned = _default_alloc_aligned;
+    alloc.free_aligned = _default_free_aligned;
+    alloc.free_sized = _default_free_sized;
     return alloc;
 }
 
+//VIRTUAL MEMORY
+
+#ifndef KIT_VM_COMMIT_SIZE
+#define KIT_VM_COMMIT_SIZE (64 * 1024)
+#endif
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+static void* _vm_reserve(size_t size) {
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+static bool _vm_commit(void* ptr, size_t size) {
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+}
+
+static void _vm_decommit(void* ptr, size_t size) {
+    VirtualFree(ptr, size, MEM_DECOMMIT);
+}
+
+static void _vm_release(void* ptr, size_t size) {
+    (void)size;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
+#else
+#include <sys/mman.h>
+
+static void* _vm_reserve(size_t size) {
+    void* ptr = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+static bool _vm_commit(void* ptr, size_t size) {
+    return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+static void _vm_decommit(void* ptr, size_t size) {
+    madvise(ptr, size, MADV_DONTNEED);
+    mprotect(ptr, size, PROT_NONE);
+}
+
+static void _vm_release(void* ptr, size_t size) {
+    munmap(ptr, size);
+}
+#endif
+
 //ARENA
 
-typedef struct {
-    kit_allocator* alloc;
-    char* buffer;
+typedef struct arena_block {
+    struct arena_block* prev;
     size_t capacity;
     size_t offset;
+} arena_block;
+
+//stored right in front of every arena allocation, so realloc knows how much to copy
+typedef struct {
+    size_t size;
+    size_t prev_offset;
+} arena_header;
+
+typedef struct {
+    kit_allocator parent;
+    arena_block* current;
+    char* last;
+    size_t block_size;
+    size_t reserve; //size of the reserved address range for virtual memory arenas, 0 otherwise
     size_t align;
+    size_t used;
+    size_t peak;
 } arena_t;
 
-static size_t _align_forward(size_t ptr, size_t align) {
-    size_t mod = ptr % align;
-    return mod == 0 ? ptr : ptr + (align - mod);
+static char* _arena_block_data(arena_block* block) {
+    return (char*)block + sizeof(arena_block);
 }
 
-static void* _arena_alloc(size_t size, void* udata) {
+static arena_header* _arena_header(void* ptr) {
+    return (arena_header*)((char*)ptr - sizeof(arena_header));
+}
+
+static arena_block* _arena_push_block(arena_t* arena, size_t min_size) {
+    //leave room to align the first allocation in the block, grow geometrically to keep the chain short
+    size_t capacity = min_size + sizeof(arena_header) + arena->align;
+    if (capacity < arena->block_size) capacity = arena->block_size;
+    if (arena->current && capacity < arena->current->capacity * 2) capacity = arena->current->capacity * 2;
+
+    arena_block* block = (arena_block*)kit_alloc(&arena->parent, sizeof(arena_block) + capacity);
+    if (!block) return NULL;
+    block->prev = arena->current;
+    block->capacity = capacity;
+    block->offset = 0;
+    arena->current = block;
+    arena->last = NULL;
+    return block;
+}
+
+//virtual memory arenas have a single block that grows by committing more of the reserved range
+static arena_block* _arena_commit(arena_t* arena, size_t capacity) {
+    arena_block* block = arena->current;
+    size_t data = (size_t)_arena_block_data(block);
+    size_t reserve_end = (size_t)arena + arena->reserve;
+    size_t commit_end = _align_forward(data + capacity, KIT_VM_COMMIT_SIZE);
+    if (commit_end > reserve_end) commit_end = reserve_end;
+    if (data + capacity > commit_end) return NULL;
+
+    size_t current_end = data + block->capacity;
+    if (commit_end > current_end && !_vm_commit((void*)current_end, commit_end - current_end)) return NULL;
+    block->capacity = commit_end - data;
+    return block;
+}
+
+static void _arena_set_offset(arena_t* arena, size_t offset) {
+    arena->used = arena->used - arena->current->offset + offset;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    arena->current->offset = offset;
+}
+
+static void* _arena_alloc_aligned(size_t size, size_t align, void* udata) {
     arena_t* arena = (arena_t*)udata;
-    size_t current = (size_t)arena->buffer + arena->offset;
-    size_t aligned = _align_forward(current, arena->align);
-    size_t new_offset = aligned - (size_t)arena->buffer + size;
+    arena_block* block = arena->current;
+    if (align < arena->align) align = arena->align;
 
-    if(new_offset > arena->capacity) return NULL;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (block) {
+            char* data = _arena_block_data(block);
+            size_t current = (size_t)data + block->offset + sizeof(arena_header);
+            size_t aligned = _align_forward(current, align);
+            size_t new_offset = aligned - (size_t)data + size;
 
-    void* ret = (void*)(arena->buffer + (aligned - (size_t)arena->buffer));
-    arena->offset = new_offset;
-    return ret;
+            if (new_offset <= block->capacity) {
+                arena_header* hdr = _arena_header((void*)aligned);
+                hdr->size = size;
+                hdr->prev_offset = block->offset;
+                _arena_set_offset(arena, new_offset);
+                arena->last = (char*)aligned;
+                return (void*)aligned;
+            }
+        }
+        block = arena->reserve
+            ? _arena_commit(arena, block->offset + sizeof(arena_header) + align + size)
+            : _arena_push_block(arena, size + align);
+        if (!block) return NULL;
+    }
+    return NULL;
 }
 
-static void* _arena_realloc(void* ptr, size_t size, void* udata) {
-    (void)ptr;
-    return _arena_alloc(size, udata);
+static void* _arena_alloc(size_t size, void* udata) {
+    return _arena_alloc_aligned(size, 0, udata);
+}
+
+static void _arena_free(void* ptr, void* udata) {
+    arena_t* arena = (arena_t*)udata;
+    //only the most recent allocation can be given back
+    if (ptr && ptr == arena->last) {
+        _arena_set_offset(arena, _arena_header(ptr)->prev_offset);
+        arena->last = NULL;
+    }
 }
 
-static void _arena_free(kit_allocator* alloc, void* ptr) {
-    (void)alloc; (void)ptr;
+static void _arena_free_sized(void* ptr, size_t size, void* udata) {
+    (void)size;
+    _arena_free(ptr, udata);
+}
+
+static void* _arena_realloc(void* ptr, size_t size, void* udata) {
+    arena_t* arena = (arena_t*)udata;
+    if (!ptr) return _arena_alloc(size, udata);
+    if (size == 0) {
+        _arena_free(ptr, udata);
+        return NULL;
+    }
+
+    arena_header* hdr = _arena_header(ptr);
+    if (ptr == arena->last) {
+        size_t new_offset = (size_t)((char*)ptr - _arena_block_data(arena->current)) + size;
+        if (new_offset > arena->current->capacity && arena->reserve) _arena_commit(arena, new_offset);
+        if (new_offset <= arena->current->capacity) {
+            hdr->size = size;
+            _arena_set_offset(arena, new_offset);
+            return ptr;
+        }
+    } else if (size <= hdr->size) {
+        hdr->size = size;
+        return ptr;
+    }
+
+    size_t old_size = hdr->size;
+    void* ret = _arena_alloc(size, udata);
+    if (ret) memcpy(ret, ptr, old_size < size ? old_size : size);
+    return ret;
 }
 
 void kit_release_arena(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata) return;
     arena_t* arena = (arena_t*)alloc->udata;
-    kit_free(arena->alloc, arena->buffer);
-    kit_free(alloc, arena);
-    arena->buffer = NULL;
-    arena->capacity = 0;
-    arena->offset = 0;
+    if (arena->reserve) {
+        _vm_release(arena, arena->reserve);
+        *alloc = (kit_allocator){0};
+        return;
+    }
+    kit_allocator parent = arena->parent;
+    arena_block* block = arena->current;
+    while (block) {
+        arena_block* prev = block->prev;
+        kit_free(&parent, block);
+        block = prev;
+    }
+    kit_free(&parent, arena);
+    *alloc = (kit_allocator){0};
+}
+
+static void _arena_free_all(void* udata) {
+    arena_t* arena = (arena_t*)udata;
+
+    //keep the largest block, so the next pass most likely fits without chaining
+    arena_block* largest = NULL;
+    for (arena_block* b = arena->current; b; b = b->prev) {
+        if (!largest || b->capacity > largest->capacity) largest = b;
+    }
+    arena_block* block = arena->current;
+    while (block) {
+        arena_block* prev = block->prev;
+        if (block != largest) kit_free(&arena->parent, block);
+        block = prev;
+    }
+    if (largest) {
+        largest->prev = NULL;
+        largest->offset = 0;
+    }
+    arena->current = largest;
+    arena->last = NULL;
+    arena->used = 0;
 }
 
 void kit_arena_reset(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata) return;
+    _arena_free_all(alloc->udata);
+}
+
+kit_arena_stats kit_arena_get_stats(kit_allocator* alloc) {
+    kit_arena_stats stats = {0};
+    if (!alloc || !alloc->udata) return stats;
     arena_t* arena = (arena_t*)alloc->udata;
-    arena->offset = 0;
+    stats.used = arena->used;
+    stats.peak = arena->peak;
+    for (arena_block* b = arena->current; b; b = b->prev) {
+        stats.reserved += b->capacity;
+        stats.block_count++;
+    }
+    return stats;
+}
+
+kit_arena_marker kit_arena_mark(kit_allocator* alloc) {
+    kit_arena_marker marker = {0};
+    if (!alloc || !alloc->udata) return marker;
+    arena_t* arena = (arena_t*)alloc->udata;
+    marker.block = arena->current;
+    marker.offset = arena->current ? arena->current->offset : 0;
+    marker.used = arena->used;
+    return marker;
+}
+
+void kit_arena_rewind(kit_allocator* alloc, kit_arena_marker marker) {
+    if (!alloc || !alloc->udata) return;
+    arena_t* arena = (arena_t*)alloc->udata;
+
+    //blocks chained after the marker are returned, the oldest one is kept if the arena was empty
+    while (arena->current && arena->current != marker.block) {
+        if (!marker.block && !arena->current->prev) break;
+        arena_block* prev = arena->current->prev;
+        kit_free(&arena->parent, arena->current);
+        arena->current = prev;
+    }
+    if (arena->current) arena->current->offset = marker.offset;
+    arena->last = NULL;
+    arena->used = marker.used;
 }
 
 kit_allocator kit_arena_allocator(kit_allocator* alloc, size_t capacity, size_t align) {
     arena_t* arena = (arena_t*)kit_alloc(alloc, sizeof(arena_t));
     if (!arena) return (kit_allocator){0};
-    arena->buffer = (char*)kit_alloc(alloc, capacity);
-    if(!arena->buffer) return (kit_allocator){0};
-    arena->capacity = capacity;
-    arena->align = align;
-    arena->offset = 0;
+    arena->parent = *alloc;
+    arena->current = NULL;
+    arena->last = NULL;
+    arena->block_size = capacity;
+    arena->reserve = 0;
+    arena->align = KIT_DEF(align, 2 * sizeof(void*));
+    arena->used = 0;
+    arena->peak = 0;
+    if (capacity && !_arena_push_block(arena, 0)) {
+        kit_free(alloc, arena);
+        return (kit_allocator){0};
+    }
     kit_allocator ret = {
-        .alloc = (kit_alloc_fn)_arena_alloc,
-        .realloc = (kit_realloc_fn)_arena_realloc,
-        .free = (kit_free_fn)_arena_free,
+        .alloc = _arena_alloc,
+        .realloc = _arena_realloc,
+        .free = _arena_free,
+        .alloc_aligned = _arena_alloc_aligned,
+        .free_aligned = _arena_free,
+        .free_sized = _arena_free_sized,
+        .free_all = _arena_free_all,
         .udata = arena
     };
     return ret;
 }
+
+kit_allocator kit_vm_arena_allocator(size_t reserve, size_t align) {
+    //the arena state and its single block live at the start of the reserved range
+    reserve = _align_forward(KIT_DEF(reserve, (size_t)1 << 30), KIT_VM_COMMIT_SIZE);
+    arena_t* arena = (arena_t*)_vm_reserve(reserve);
+    if (!arena) return (kit_allocator){0};
+    if (!_vm_commit(arena, KIT_VM_COMMIT_SIZE)) {
+        _vm_release(arena, reserve);
+        return (kit_allocator){0};
+    }
+    memset(arena, 0, sizeof(arena_t));
+    arena->reserve = reserve;
+    arena->align = KIT_DEF(align, 2 * sizeof(void*));
+
+    arena_block* block = (arena_block*)_align_forward((size_t)arena + sizeof(arena_t), 2 * sizeof(void*));
+    block->prev = NULL;
+    block->offset = 0;
+    block->capacity = (size_t)arena + KIT_VM_COMMIT_SIZE - (size_t)_arena_block_data(block);
+    arena->current = block;
+
+    kit_allocator ret = {
+        .alloc = _arena_alloc,
+        .realloc = _arena_realloc,
+        .free = _arena_free,
+        .alloc_aligned = _arena_alloc_aligned,
+        .free_aligned = _arena_free,
+        .free_sized = _arena_free_sized,
+        .free_all = _arena_free_all,
+        .udata = arena
+    };
+    return ret;
+}
+
+void kit_arena_decommit(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata) return;
+    arena_t* arena = (arena_t*)alloc->udata;
+    if (!arena->reserve) return;
+
+    arena_block* block = arena->current;
+    size_t data = (size_t)_arena_block_data(block);
+    size_t keep_end = _align_forward(data + block->offset, KIT_VM_COMMIT_SIZE);
+    size_t commit_end = data + block->capacity;
+    if (keep_end < commit_end) {
+        _vm_decommit((void*)keep_end, commit_end - keep_end);
+        block->capacity = keep_end - data;
+    }
+}
+
+//SCRATCH
+
+#ifndef KIT_SCRATCH_BLOCK_SIZE
+#define KIT_SCRATCH_BLOCK_SIZE (256 * 1024)
+#endif
+
+static KIT_THREAD_LOCAL kit_allocator _scratch_arena;
+
+kit_scratch kit_scratch_begin(void) {
+    if (!_scratch_arena.udata) {
+        kit_allocator parent = kit_default_allocator();
+        _scratch_arena = kit_arena_allocator(&parent, KIT_SCRATCH_BLOCK_SIZE, 0);
+    }
+    kit_scratch scratch = {
+        .alloc = &_scratch_arena,
+        .marker = kit_arena_mark(&_scratch_arena)
+    };
+    return scratch;
+}
+
+void kit_scratch_end(kit_scratch* scratch) {
+    if (!scratch || !scratch->alloc) return;
+    kit_arena_rewind(scratch->alloc, scratch->marker);
+    scratch->alloc = NULL;
+}
+
+void kit_release_scratch(void) {
+    kit_release_arena(&_scratch_arena);
+}
+
+//ATOMIC ARENA
+
+typedef struct atomic_block {
+    struct atomic_block* prev;
+    uint64_t capacity;
+    volatile uint64_t offset;
+} atomic_block;
+
+typedef struct {
+    kit_allocator parent;
+    void* volatile current;
+    size_t block_size;
+    size_t align;
+    size_t thread_cache;
+    volatile uint32_t generation;
+} atomic_arena_t;
+
+//sub-block a thread carves allocations from without atomics
+typedef struct {
+    atomic_arena_t* arena;
+    uint32_t generation;
+    size_t ptr;
+    size_t end;
+} atomic_arena_cache;
+
+static KIT_THREAD_LOCAL atomic_arena_cache _atomic_arena_cache;
+//unique across arenas, so a cache can't be mistaken for one of a new arena at the same address
+static volatile uint32_t _atomic_arena_generation;
+
+static char* _atomic_block_data(atomic_block* block) {
+    return (char*)block + sizeof(atomic_block);
+}
+
+static void* _atomic_arena_bump(atomic_arena_t* arena, size_t header, size_t size, size_t align) {
+    for (;;) {
+        atomic_block* block = (atomic_block*)_kit_atomic_load_ptr(&arena->current);
+        if (block) {
+            uint64_t offset = _kit_atomic_load_u64(&block->offset);
+            size_t data = (size_t)_atomic_block_data(block);
+            size_t aligned = _align_forward(data + (size_t)offset + header, align);
+            uint64_t new_offset = aligned - data + size;
+            if (new_offset <= block->capacity) {
+                if (_kit_atomic_cas_u64(&block->offset, &offset, new_offset)) return (void*)aligned;
+                continue;
+            }
+        }
+
+        //racing threads each build a block, only one gets published
+        size_t capacity = header + size + align;
+        if (capacity < arena->block_size) capacity = arena->block_size;
+        if (block && capacity < block->capacity * 2) capacity = (size_t)block->capacity * 2;
+        atomic_block* next = (atomic_block*)kit_alloc(&arena->parent, sizeof(atomic_block) + capacity);
+        if (!next) return NULL;
+        next->prev = block;
+        next->capacity = capacity;
+        next->offset = 0;
+        void* expected = block;
+        if (!_kit_atomic_cas_ptr(&arena->current, &expected, next)) {
+            kit_free(&arena->parent, next);
+        }
+    }
+}
+
+static void* _atomic_arena_alloc_aligned(size_t size, size_t align, void* udata) {
+    atomic_arena_t* arena = (atomic_arena_t*)udata;
+    if (align < arena->align) align = arena->align;
+
+    if (arena->thread_cache && size + align + sizeof(arena_header) <= arena->thread_cache / 4) {
+        atomic_arena_cache* cache = &_atomic_arena_cache;
+        uint32_t generation = _kit_atomic_load_u32(&arena->generation);
+        for (int attempt = 0; attempt < 2; attempt++) {
+            if (cache->arena == arena && cache->generation == generation) {
+                size_t aligned = _align_forward(cache->ptr + sizeof(arena_header), align);
+                if (aligned + size <= cache->end) {
+                    cache->ptr = aligned + size;
+                    _arena_header((void*)aligned)->size = size;
+                    return (void*)aligned;
+                }
+            }
+            char* sub = (char*)_atomic_arena_bump(arena, 0, arena->thread_cache, arena->align);
+            if (!sub) return NULL;
+            cache->arena = arena;
+            cache->generation = generation;
+            cache->ptr = (size_t)sub;
+            cache->end = (size_t)sub + arena->thread_cache;
+        }
+    }
+
+    void* ret = _atomic_arena_bump(arena, sizeof(arena_header), size, align);
+    if (ret) _arena_header(ret)->size = size;
+    return ret;
+}
+
+static void* _atomic_arena_alloc(size_t size, void* udata) {
+    return _atomic_arena_alloc_aligned(size, 0, udata);
+}
+
+static void _atomic_arena_free(void* ptr, void* udata) {
+    (void)ptr; (void)udata;
+}
+
+static void* _atomic_arena_realloc(void* ptr, size_t size, void* udata) {
+    if (!ptr) return _atomic_arena_alloc(size, udata);
+    if (size == 0) return NULL;
+    size_t old_size = _arena_header(ptr)->size;
+    if (size <= old_size) return ptr;
+    void* ret = _atomic_arena_alloc(size, udata);
+    if (ret) memcpy(ret, ptr, old_size);
+    return ret;
+}
+
+static void _atomic_arena_free_sized(void* ptr, size_t size, void* udata) {
+    (void)ptr; (void)size; (void)udata;
+}
+
+static void _atomic_arena_free_all(void* udata) {
+    atomic_arena_t* arena = (atomic_arena_t*)udata;
+
+    atomic_block* largest = NULL;
+    for (atomic_block* b = (atomic_block*)arena->current; b; b = b->prev) {
+        if (!largest || b->capacity > largest->capacity) largest = b;
+    }
+    atomic_block* block = (atomic_block*)arena->current;
+    while (block) {
+        atomic_block* prev = block->prev;
+        if (block != largest) kit_free(&arena->parent, block);
+        block = prev;
+    }
+    if (largest) {
+        largest->prev = NULL;
+        _kit_atomic_store_u64(&largest->offset, 0);
+    }
+    _kit_atomic_store_ptr(&arena->current, largest);
+    //drops every thread cache pointing into the old blocks
+    _kit_atomic_store_u32(&arena->generation, _kit_atomic_add_u32(&_atomic_arena_generation, 1) + 1);
+}
+
+void kit_atomic_arena_reset(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata) return;
+    _atomic_arena_free_all(alloc->udata);
+}
+
+void kit_release_atomic_arena(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata) return;
+    atomic_arena_t* arena = (atomic_arena_t*)alloc->udata;
+    kit_allocator parent = arena->parent;
+    atomic_block* block = (atomic_block*)arena->current;
+    while (block) {
+        atomic_block* prev = block->prev;
+        kit_free(&parent, block);
+        block = prev;
+    }
+    kit_free(&parent, arena);
+    *alloc = (kit_allocator){0};
+}
+
+kit_allocator kit_atomic_arena_allocator(kit_allocator* alloc, size_t capacity, size_t align, size_t thread_cache) {
+    if (!alloc) return (kit_allocator){0};
+    atomic_arena_t* arena = (atomic_arena_t*)kit_alloc(alloc, sizeof(atomic_arena_t));
+    if (!arena) return (kit_allocator){0};
+    memset(arena, 0, sizeof(atomic_arena_t));
+    arena->parent = *alloc;
+    arena->block_size = capacity;
+    arena->align = KIT_DEF(align, 2 * sizeof(void*));
+    arena->thread_cache = thread_cache;
+    arena->generation = _kit_atomic_add_u32(&_atomic_arena_generation, 1) + 1;
+    kit_allocator ret = {
+        .alloc = _atomic_arena_alloc,
+        .realloc = _atomic_arena_realloc,
+        .free = _atomic_arena_free,
+        .alloc_aligned = _atomic_arena_alloc_aligned,
+        .free_aligned = _atomic_arena_free,
+        .free_sized = _atomic_arena_free_sized,
+        .free_all = _atomic_arena_free_all,
+        .udata = arena
+    };
+    return ret;
+}
+
+//FRAME
+
+#define FRAME_MAX_BUFFERS 4
+
+typedef struct {
+    kit_allocator arenas[FRAME_MAX_BUFFERS];
+    kit_allocator parent;
+    int count;
+    int current;
+} frame_t;
+
+static kit_allocator* _frame_arena(void* udata) {
+    frame_t* frame = (frame_t*)udata;
+    return &frame->arenas[frame->current];
+}
+
+static void* _frame_alloc(size_t size, void* udata) {
+    return kit_alloc(_frame_arena(udata), size);
+}
+
+static void* _frame_realloc(void* ptr, size_t size, void* udata) {
+    return kit_realloc(_frame_arena(udata), ptr, size);
+}
+
+static void _frame_free(void* ptr, void* udata) {
+    kit_free(_frame_arena(udata), ptr);
+}
+
+static void _frame_free_sized(void* ptr, size_t size, void* udata) {
+    kit_free_sized(_frame_arena(udata), ptr, size);
+}
+
+static void _frame_free_all(void* udata) {
+    kit_free_all(_frame_arena(udata));
+}
+
+static void* _frame_alloc_aligned(size_t size, size_t align, void* udata) {
+    return kit_alloc_aligned(_frame_arena(udata), size, align);
+}
+
+static void _frame_free_aligned(void* ptr, void* udata) {
+    kit_free_aligned(_frame_arena(udata), ptr);
+}
+
+void kit_frame_advance(kit_allocator* alloc, uint32_t frame_number) {
+    if (!alloc || !alloc->udata) return;
+    frame_t* frame = (frame_t*)alloc->udata;
+    //the buffer picked here was last written buffer_count frames ago, bgfx is done with it by now
+    frame->current = (int)(frame_number % (uint32_t)frame->count);
+    kit_arena_reset(&frame->arenas[frame->current]);
+}
+
+uint32_t kit_frame(kit_allocator* alloc, bool capture) {
+    uint32_t frame_number = bgfx_frame(capture);
+    kit_frame_advance(alloc, frame_number);
+    return frame_number;
+}
+
+const bgfx_memory_t* kit_frame_ref(kit_allocator* alloc, uint32_t size) {
+    void* data = kit_alloc_aligned(alloc, size, KIT_SIMD_ALIGN);
+    return data ? bgfx_make_ref(data, size) : NULL;
+}
+
+void kit_release_frame_allocator(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata) return;
+    frame_t* frame = (frame_t*)alloc->udata;
+    kit_allocator parent = frame->parent;
+    for (int i = 0; i < frame->count; i++) {
+        kit_release_arena(&frame->arenas[i]);
+    }
+    kit_free(&parent, frame);
+    *alloc = (kit_allocator){0};
+}
+
+kit_allocator kit_frame_allocator(kit_allocator* alloc, size_t capacity, int buffer_count) {
+    if (!alloc) return (kit_allocator){0};
+    buffer_count = KIT_DEF(buffer_count, 2);
+    if (buffer_count < 2 || buffer_count > FRAME_MAX_BUFFERS) {
+        kit_log_error("Frame allocator needs 2 to %d buffers, got %d", FRAME_MAX_BUFFERS, buffer_count);
+        return (kit_allocator){0};
+    }
+    frame_t* frame = (frame_t*)kit_alloc(alloc, sizeof(frame_t));
+    if (!frame) return (kit_allocator){0};
+    memset(frame, 0, sizeof(frame_t));
+    frame->parent = *alloc;
+    frame->count = buffer_count;
+    for (int i = 0; i < buffer_count; i++) {
+        frame->arenas[i] = kit_arena_allocator(alloc, capacity, KIT_SIMD_ALIGN);
+        if (!frame->arenas[i].udata) {
+            kit_allocator ret = { .udata = frame };
+            kit_release_frame_allocator(&ret);
+            return ret;
+        }
+    }
+    kit_allocator ret = {
+        .alloc = _frame_alloc,
+        .realloc = _frame_realloc,
+        .free = _frame_free,
+        .alloc_aligned = _frame_alloc_aligned,
+        .free_aligned = _frame_free_aligned,
+        .free_sized = _frame_free_sized,
+        .free_all = _frame_free_all,
+        .udata = frame
+    };
+    return ret;
+}
+
+//POOL
+
+#ifndef KIT_POOL_ZERO_ON_FREE
+#define KIT_POOL_ZERO_ON_FREE 0
+#endif
+
+typedef struct pool_chunk {
+    struct pool_chunk* next;
+} pool_chunk;
+
+typedef struct pool_node {
+    struct pool_node* next;
+} pool_node;
+
+typedef struct {
+    kit_allocator parent;
+    pool_chunk* chunks;
+    pool_node* free_list;
+    size_t block_size;
+    size_t stride;
+    size_t count;
+} pool_t;
+
+#define POOL_ALIGN (2 * sizeof(void*))
+
+#define POOL_CHUNK_HEADER _align_forward(sizeof(pool_chunk), POOL_ALIGN)
+
+//threads the blocks of a chunk onto the free list in address order
+static void _pool_thread_chunk(pool_t* pool, pool_chunk* chunk) {
+    char* blocks = (char*)chunk + POOL_CHUNK_HEADER;
+    for (size_t i = pool->count; i > 0; i--) {
+        pool_node* node = (pool_node*)(blocks + (i - 1) * pool->stride);
+        node->next = pool->free_list;
+        pool->free_list = node;
+    }
+}
+
+static bool _pool_grow(pool_t* pool) {
+    pool_chunk* chunk = (pool_chunk*)kit_alloc(&pool->parent, POOL_CHUNK_HEADER + pool->stride * pool->count);
+    if (!chunk) return false;
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+    _pool_thread_chunk(pool, chunk);
+    return true;
+}
+
+static void* _pool_alloc(size_t size, void* udata) {
+    pool_t* pool = (pool_t*)udata;
+    if (size > pool->block_size) return NULL;
+    if (!pool->free_list && !_pool_grow(pool)) return NULL;
+    pool_node* node = pool->free_list;
+    pool->free_list = node->next;
+    return node;
+}
+
+static void* _pool_alloc_aligned(size_t size, size_t align, void* udata) {
+    //blocks are only guaranteed the alignment of the stride
+    if (align > POOL_ALIGN) return NULL;
+    return _pool_alloc(size, udata);
+}
+
+static void* _pool_realloc(void* ptr, size_t size, void* udata) {
+    pool_t* pool = (pool_t*)udata;
+    if (!ptr) return _pool_alloc(size, udata);
+    return size <= pool->block_size ? ptr : NULL;
+}
+
+static void _pool_free(void* ptr, void* udata) {
+    pool_t* pool = (pool_t*)udata;
+    if (!ptr) return;
+#if KIT_POOL_ZERO_ON_FREE
+    memset(ptr, 0, pool->stride);
+#endif
+    pool_node* node = (pool_node*)ptr;
+    node->next = pool->free_list;
+    pool->free_list = node;
+}
+
+static void _pool_free_sized(void* ptr, size_t size, void* udata) {
+    KIT_ASSERT(size <= ((pool_t*)udata)->block_size);
+    (void)size;
+    _pool_free(ptr, udata);
+}
+
+static void _pool_free_all(void* udata) {
+    pool_t* pool = (pool_t*)udata;
+    pool->free_list = NULL;
+    for (pool_chunk* chunk = pool->chunks; chunk; chunk = chunk->next) {
+        _pool_thread_chunk(pool, chunk);
+    }
+}
+
+void kit_release_pool(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata) return;
+    pool_t* pool = (pool_t*)alloc->udata;
+    kit_allocator parent = pool->parent;
+    pool_chunk* chunk = pool->chunks;
+    while (chunk) {
+        pool_chunk* next = chunk->next;
+        kit_free(&parent, chunk);
+        chunk = next;
+    }
+    kit_free(&parent, pool);
+    *alloc = (kit_allocator){0};
+}
+
+kit_allocator kit_pool_allocator(kit_allocator* alloc, size_t block_size, size_t count) {
+    if (!alloc || block_size == 0) return (kit_allocator){0};
+    pool_t* pool = (pool_t*)kit_alloc(alloc, sizeof(pool_t));
+    if (!pool) return (kit_allocator){0};
+    pool->parent = *alloc;
+    pool->chunks = NULL;
+    pool->free_list = NULL;
+    pool->block_size = block_size;
+    pool->stride = _align_forward(block_size < sizeof(pool_node) ? sizeof(pool_node) : block_size, POOL_ALIGN);
+    pool->count = KIT_DEF(count, 64);
+    if (!_pool_grow(pool)) {
+        kit_free(alloc, pool);
+        return (kit_allocator){0};
+    }
+    kit_allocator ret = {
+        .alloc = _pool_alloc,
+        .realloc = _pool_realloc,
+        .free = _pool_free,
+        .alloc_aligned = _pool_alloc_aligned,
+        .free_aligned = _pool_free,
+        .free_sized = _pool_free_sized,
+        .free_all = _pool_free_all,
+        .udata = pool
+    };
+    return ret;
+}
+
+//TLSF
+//two-level segregated fit, see http://www.gii.upv.es/tlsf/
+
+#if UINTPTR_MAX > 0xFFFFFFFF
+#define TLSF_ALIGN_LOG2 4
+#define TLSF_FL_MAX 32
+#else
+#define TLSF_ALIGN_LOG2 3
+#define TLSF_FL_MAX 30
+#endif
+#define TLSF_ALIGN ((size_t)1 << TLSF_ALIGN_LOG2)
+#define TLSF_SL_LOG2 5
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_FL_COUNT (TLSF_FL_MAX - TLSF_FL_SHIFT + 1)
+#define TLSF_SMALL_BLOCK ((size_t)1 << TLSF_FL_SHIFT)
+#define TLSF_BLOCK_MAX (((size_t)1 << TLSF_FL_MAX) - TLSF_ALIGN)
+
+//the header is exactly TLSF_ALIGN bytes, the free list links live in the payload of free blocks
+typedef struct tlsf_block {
+    struct tlsf_block* prev_phys;
+    size_t size; //payload size, bit 0 marks the block as free
+    struct tlsf_block* next_free;
+    struct tlsf_block* prev_free;
+} tlsf_block;
+
+#define TLSF_HEADER (2 * sizeof(void*))
+#define TLSF_MIN_PAYLOAD (sizeof(tlsf_block) - TLSF_HEADER)
+
+typedef struct tlsf_region {
+    struct tlsf_region* next;
+    size_t size;
+} tlsf_region;
+
+typedef struct {
+    kit_allocator parent;
+    tlsf_region* regions;
+    size_t region_size;
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[TLSF_FL_COUNT];
+    tlsf_block* blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];
+} tlsf_t;
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+static int _tlsf_ffs(uint32_t word) {
+    unsigned long index;
+    return _BitScanForward(&index, word) ? (int)index : -1;
+}
+static int _fls_size(size_t size) {
+    unsigned long index;
+#if UINTPTR_MAX > 0xFFFFFFFF
+    return _BitScanReverse64(&index, (unsigned __int64)size) ? (int)index : -1;
+#else
+    return _BitScanReverse(&index, (unsigned long)size) ? (int)index : -1;
+#endif
+}
+#else
+static int _tlsf_ffs(uint32_t word) {
+    return word ? __builtin_ctz(word) : -1;
+}
+static int _fls_size(size_t size) {
+    return size ? (int)(sizeof(unsigned long long) * 8 - 1) - __builtin_clzll((unsigned long long)size) : -1;
+}
+#endif
+
+static size_t _tlsf_size(const tlsf_block* block) {
+    return block->size & ~(size_t)1;
+}
+
+static bool _tlsf_is_free(const tlsf_block* block) {
+    return (block->size & 1) != 0;
+}
+
+static void* _tlsf_payload(tlsf_block* block) {
+    return (char*)block + TLSF_HEADER;
+}
+
+static tlsf_block* _tlsf_from_payload(void* ptr) {
+    return (tlsf_block*)((char*)ptr - TLSF_HEADER);
+}
+
+static tlsf_block* _tlsf_next_phys(tlsf_block* block) {
+    return (tlsf_block*)((char*)block + TLSF_HEADER + _tlsf_size(block));
+}
+
+static void _tlsf_mapping_insert(size_t size, int* fl, int* sl) {
+    if (size < TLSF_SMALL_BLOCK) {
+        *fl = 0;
+        *sl = (int)(size >> TLSF_ALIGN_LOG2);
+    } else {
+        int f = _fls_size(size);
+        *sl = (int)(size >> (f - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+        *fl = f - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+//rounds up to the next list, so any block found there is large enough
+static void _tlsf_mapping_search(size_t size, int* fl, int* sl) {
+    if (size >= TLSF_SMALL_BLOCK) {
+        size += ((size_t)1 << (_fls_size(size) - TLSF_SL_LOG2)) - 1;
+    }
+    _tlsf_mapping_insert(size, fl, sl);
+}
+
+static void _tlsf_remove_free(tlsf_t* tlsf, tlsf_block* block) {
+    int fl, sl;
+    _tlsf_mapping_insert(_tlsf_size(block), &fl, &sl);
+    if (block->next_free) block->next_free->prev_free = block->prev_free;
+    if (block->prev_free) block->prev_free->next_free = block->next_free;
+    if (tlsf->blocks[fl][sl] == block) {
+        tlsf->blocks[fl][sl] = block->next_free;
+        if (!block->next_free) {
+            tlsf->sl_bitmap[fl] &= ~(1u << sl);
+            if (!tlsf->sl_bitmap[fl]) tlsf->fl_bitmap &= ~(1u << fl);
+        }
+    }
+    block->size &= ~(size_t)1;
+}
+
+static void _tlsf_insert_free(tlsf_t* tlsf, tlsf_block* block) {
+    int fl, sl;
+    _tlsf_mapping_insert(_tlsf_size(block), &fl, &sl);
+    tlsf_block* head = tlsf->blocks[fl][sl];
+    block->size |= 1;
+    block->prev_free = NULL;
+    block->next_free = head;
+    if (head) head->prev_free = block;
+    tlsf->blocks[fl][sl] = block;
+    tlsf->fl_bitmap |= 1u << fl;
+    tlsf->sl_bitmap[fl] |= 1u << sl;
+}
+
+static tlsf_block* _tlsf_find_free(tlsf_t* tlsf, size_t size) {
+    int fl, sl;
+    _tlsf_mapping_search(size, &fl, &sl);
+    if (fl >= TLSF_FL_COUNT) return NULL;
+
+    uint32_t sl_map = tlsf->sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        uint32_t fl_map = fl + 1 < 32 ? tlsf->fl_bitmap & (~0u << (fl + 1)) : 0;
+        if (!fl_map) return NULL;
+        fl = _tlsf_ffs(fl_map);
+        sl_map = tlsf->sl_bitmap[fl];
+    }
+    sl = _tlsf_ffs(sl_map);
+    return tlsf->blocks[fl][sl];
+}
+
+//splits the tail of a used block off into a new free block if it is big enough
+static void _tlsf_trim(tlsf_t* tlsf, tlsf_block* block, size_t size) {
+    size_t block_size = _tlsf_size(block);
+    if (block_size < size + TLSF_HEADER + TLSF_MIN_PAYLOAD) return;
+
+    tlsf_block* rest = (tlsf_block*)((char*)_tlsf_payload(block) + size);
+    rest->prev_phys = block;
+    rest->size = block_size - size - TLSF_HEADER;
+    block->size = size;
+
+    tlsf_block* next = _tlsf_next_phys(rest);
+    if (_tlsf_is_free(next)) {
+        _tlsf_remove_free(tlsf, next);
+        rest->size += TLSF_HEADER + _tlsf_size(next);
+        next = _tlsf_next_phys(rest);
+    }
+    next->prev_phys = rest;
+    _tlsf_insert_free(tlsf, rest);
+}
+
+//one free block spanning the region, followed by a used zero-sized sentinel
+static void _tlsf_init_region(tlsf_t* tlsf, tlsf_region* region) {
+    size_t start = _align_forward((size_t)region + sizeof(tlsf_region), TLSF_ALIGN);
+    size_t end = ((size_t)region + region->size - TLSF_HEADER) & ~(TLSF_ALIGN - 1);
+    tlsf_block* block = (tlsf_block*)start;
+    block->prev_phys = NULL;
+    block->size = end - start - TLSF_HEADER;
+
+    tlsf_block* sentinel = (tlsf_block*)end;
+    sentinel->prev_phys = block;
+    sentinel->size = 0;
+
+    _tlsf_insert_free(tlsf, block);
+}
+
+static bool _tlsf_add_region(tlsf_t* tlsf, size_t min_size) {
+    size_t overhead = _align_forward(sizeof(tlsf_region), TLSF_ALIGN) + 2 * TLSF_HEADER + TLSF_ALIGN;
+    size_t size = min_size + overhead;
+    if (size < tlsf->region_size) size = tlsf->region_size;
+    if (size - overhead > TLSF_BLOCK_MAX) size = TLSF_BLOCK_MAX + overhead;
+
+    tlsf_region* region = (tlsf_region*)kit_alloc(&tlsf->parent, size);
+    if (!region) return false;
+    region->next = tlsf->regions;
+    region->size = size;
+    tlsf->regions = region;
+    _tlsf_init_region(tlsf, region);
+    return true;
+}
+
+static size_t _tlsf_adjust_size(size_t size) {
+    size = _align_forward(size, TLSF_ALIGN);
+    return size < TLSF_MIN_PAYLOAD ? TLSF_MIN_PAYLOAD : size;
+}
+
+static void* _tlsf_alloc(size_t size, void* udata) {
+    tlsf_t* tlsf = (tlsf_t*)udata;
+    size_t adjusted = _tlsf_adjust_size(size);
+    if (size == 0 || adjusted > TLSF_BLOCK_MAX) return NULL;
+
+    tlsf_block* block = _tlsf_find_free(tlsf, adjusted);
+    if (!block) {
+        //round the request up to its list, so the new region is guaranteed to be found
+        int fl, sl;
+        _tlsf_mapping_search(adjusted, &fl, &sl);
+        size_t needed = fl == 0 ? adjusted : ((size_t)(TLSF_SL_COUNT | sl) << (fl + TLSF_FL_SHIFT - 1 - TLSF_SL_LOG2));
+        if (!_tlsf_add_region(tlsf, needed)) return NULL;
+        block = _tlsf_find_free(tlsf, adjusted);
+        if (!block) return NULL;
+    }
+    _tlsf_remove_free(tlsf, block);
+    _tlsf_trim(tlsf, block, adjusted);
+    return _tlsf_payload(block);
+}
+
+static void _tlsf_free(void* ptr, void* udata);
+
+static void* _tlsf_alloc_aligned(size_t size, size_t align, void* udata) {
+    tlsf_t* tlsf = (tlsf_t*)udata;
+    if (align <= TLSF_ALIGN) return _tlsf_alloc(size, udata);
+
+    //over-allocate, so a leading gap big enough to become a free block always fits
+    size_t adjusted = _tlsf_adjust_size(size);
+    size_t gap_min = sizeof(tlsf_block);
+    char* ptr = (char*)_tlsf_alloc(adjusted + align + gap_min, udata);
+    if (!ptr) return NULL;
+
+    size_t gap = _align_forward((size_t)ptr, align) - (size_t)ptr;
+    if (gap && gap < gap_min) {
+        gap = _align_forward((size_t)ptr + gap_min, align) - (size_t)ptr;
+    }
+    tlsf_block* block = _tlsf_from_payload(ptr);
+    if (gap) {
+        tlsf_block* aligned = _tlsf_from_payload(ptr + gap);
+        aligned->prev_phys = block;
+        aligned->size = _tlsf_size(block) - gap;
+        _tlsf_next_phys(aligned)->prev_phys = aligned;
+        block->size = gap - TLSF_HEADER;
+        _tlsf_free(ptr, udata);
+        block = aligned;
+    }
+    _tlsf_trim(tlsf, block, adjusted);
+    return _tlsf_payload(block);
+}
+
+static void _tlsf_free(void* ptr, void* udata) {
+    tlsf_t* tlsf = (tlsf_t*)udata;
+    if (!ptr) return;
+    tlsf_block* block = _tlsf_from_payload(ptr);
+
+    tlsf_block* prev = block->prev_phys;
+    if (prev && _tlsf_is_free(prev)) {
+        _tlsf_remove_free(tlsf, prev);
+        prev->size += TLSF_HEADER + _tlsf_size(block);
+        block = prev;
+    }
+    tlsf_block* next = _tlsf_next_phys(block);
+    if (_tlsf_is_free(next)) {
+        _tlsf_remove_free(tlsf, next);
+        block->size += TLSF_HEADER + _tlsf_size(next);
+        next = _tlsf_next_phys(block);
+    }
+    next->prev_phys = block;
+    _tlsf_insert_free(tlsf, block);
+}
+
+static void* _tlsf_realloc(void* ptr, size_t size, void* udata) {
+    tlsf_t* tlsf = (tlsf_t*)udata;
+    if (!ptr) return _tlsf_alloc(size, udata);
+    if (size == 0) {
+        _tlsf_free(ptr, udata);
+        return NULL;
+    }
+
+    size_t adjusted = _tlsf_adjust_size(size);
+    if (adjusted > TLSF_BLOCK_MAX) return NULL;
+    tlsf_block* block = _tlsf_from_payload(ptr);
+    size_t current = _tlsf_size(block);
+
+    //absorb the following block if that makes enough room
+    tlsf_block* next = _tlsf_next_phys(block);
+    if (adjusted > current && _tlsf_is_free(next) && current + TLSF_HEADER + _tlsf_size(next) >= adjusted) {
+        _tlsf_remove_free(tlsf, next);
+        block->size += TLSF_HEADER + _tlsf_size(next);
+        _tlsf_next_phys(block)->prev_phys = block;
+        current = _tlsf_size(block);
+    }
+    if (adjusted <= current) {
+        _tlsf_trim(tlsf, block, adjusted);
+        return ptr;
+    }
+
+    void* ret = _tlsf_alloc(size, udata);
+    if (ret) {
+        memcpy(ret, ptr, current);
+        _tlsf_free(ptr, udata);
+    }
+    return ret;
+}
+
+static void _tlsf_free_sized(void* ptr, size_t size, void* udata) {
+    (void)size;
+    _tlsf_free(ptr, udata);
+}
+
+static void _tlsf_free_all(void* udata) {
+    tlsf_t* tlsf = (tlsf_t*)udata;
+    tlsf->fl_bitmap = 0;
+    memset(tlsf->sl_bitmap, 0, sizeof(tlsf->sl_bitmap));
+    memset(tlsf->blocks, 0, sizeof(tlsf->blocks));
+    for (tlsf_region* region = tlsf->regions; region; region = region->next) {
+        _tlsf_init_region(tlsf, region);
+    }
+}
+
+void kit_release_tlsf(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata) return;
+    tlsf_t* tlsf = (tlsf_t*)alloc->udata;
+    kit_allocator parent = tlsf->parent;
+    tlsf_region* region = tlsf->regions;
+    while (region) {
+        tlsf_region* next = region->next;
+        kit_free(&parent, region);
+        region = next;
+    }
+    kit_free(&parent, tlsf);
+    *alloc = (kit_allocator){0};
+}
+
+kit_allocator kit_tlsf_allocator(kit_allocator* alloc, size_t region_size) {
+    if (!alloc) return (kit_allocator){0};
+    tlsf_t* tlsf = (tlsf_t*)kit_alloc(alloc, sizeof(tlsf_t));
+    if (!tlsf) return (kit_allocator){0};
+    memset(tlsf, 0, sizeof(tlsf_t));
+    tlsf->parent = *alloc;
+    tlsf->region_size = KIT_DEF(region_size, 16 * 1024 * 1024);
+    if (!_tlsf_add_region(tlsf, 0)) {
+        kit_free(alloc, tlsf);
+        return (kit_allocator){0};
+    }
+    kit_allocator ret = {
+        .alloc = _tlsf_alloc,
+        .realloc = _tlsf_realloc,
+        .free = _tlsf_free,
+        .alloc_aligned = _tlsf_alloc_aligned,
+        .free_aligned = _tlsf_free,
+        .free_sized = _tlsf_free_sized,
+        .free_all = _tlsf_free_all,
+        .udata = tlsf
+    };
+    return ret;
+}
+
+//TRACKING
+
+#ifndef KIT_TRACKING_MAX_TAGS
+#define KIT_TRACKING_MAX_TAGS 32
+#endif
+
+typedef struct tracking_t tracking_t;
+
+typedef struct {
+    tracking_t* tracker;
+    int index;
+} tracking_tag;
+
+//keeps the payload aligned to 16 bytes, offset is the distance from the start of the parent block
+typedef union {
+    struct {
+        size_t size;
+        int tag;
+        int offset;
+    };
+    char pad[16];
+} tracking_header;
+
+struct tracking_t {
+    kit_allocator parent;
+    tracking_tag tags[KIT_TRACKING_MAX_TAGS];
+    kit_tracking_stats stats[KIT_TRACKING_MAX_TAGS];
+    kit_tracking_stats total;
+    int tag_count;
+};
+
+static void _tracking_record_alloc(kit_tracking_stats* stats, size_t size) {
+    stats->live_bytes += size;
+    stats->live_allocs++;
+    stats->total_allocs++;
+    if (stats->live_bytes > stats->peak_bytes) stats->peak_bytes = stats->live_bytes;
+    int bin = size ? _fls_size(size) : 0;
+    stats->histogram[bin < KIT_TRACKING_HISTOGRAM_BINS ? bin : KIT_TRACKING_HISTOGRAM_BINS - 1]++;
+}
+
+static void _tracking_record_free(kit_tracking_stats* stats, size_t size) {
+    stats->live_bytes -= size;
+    stats->live_allocs--;
+}
+
+//a realloc resizes a live allocation, it is not counted as a new one
+static void _tracking_record_realloc(kit_tracking_stats* stats, size_t old_size, size_t size) {
+    stats->live_bytes += size - old_size;
+    stats->total_reallocs++;
+    if (stats->live_bytes > stats->peak_bytes) stats->peak_bytes = stats->live_bytes;
+}
+
+static void* _tracking_track(tracking_tag* tag, char* base, size_t offset, size_t size) {
+    tracking_t* tracker = tag->tracker;
+    tracking_header* hdr = (tracking_header*)(base + offset) - 1;
+    hdr->size = size;
+    hdr->tag = tag->index;
+    hdr->offset = (int)offset;
+    _tracking_record_alloc(&tracker->stats[tag->index], size);
+    _tracking_record_alloc(&tracker->total, size);
+    return base + offset;
+}
+
+static char* _tracking_untrack(tracking_t* tracker, void* ptr) {
+    tracking_header* hdr = (tracking_header*)ptr - 1;
+    //frees are booked on the tag that made the allocation
+    _tracking_record_free(&tracker->stats[hdr->tag], hdr->size);
+    _tracking_record_free(&tracker->total, hdr->size);
+    return (char*)ptr - hdr->offset;
+}
+
+static void* _tracking_alloc(size_t size, void* udata) {
+    tracking_tag* tag = (tracking_tag*)udata;
+    char* base = (char*)kit_alloc(&tag->tracker->parent, sizeof(tracking_header) + size);
+    return base ? _tracking_track(tag, base, sizeof(tracking_header), size) : NULL;
+}
+
+static void _tracking_free(void* ptr, void* udata) {
+    if (!ptr) return;
+    tracking_t* tracker = ((tracking_tag*)udata)->tracker;
+    kit_free(&tracker->parent, _tracking_untrack(tracker, ptr));
+}
+
+static void _tracking_free_sized(void* ptr, size_t size, void* udata) {
+    if (!ptr) return;
+    //catches callers that free with a different size than they allocated
+    KIT_ASSERT(((tracking_header*)ptr - 1)->size == size);
+    (void)size;
+    _tracking_free(ptr, udata);
+}
+
+static void* _tracking_alloc_aligned(size_t size, size_t align, void* udata) {
+    tracking_tag* tag = (tracking_tag*)udata;
+    size_t offset = _align_forward(sizeof(tracking_header), align);
+    char* base = (char*)kit_alloc_aligned(&tag->tracker->parent, offset + size, align);
+    return base ? _tracking_track(tag, base, offset, size) : NULL;
+}
+
+static void _tracking_free_aligned(void* ptr, void* udata) {
+    if (!ptr) return;
+    tracking_t* tracker = ((tracking_tag*)udata)->tracker;
+    kit_free_aligned(&tracker->parent, _tracking_untrack(tracker, ptr));
+}
+
+static void* _tracking_realloc(void* ptr, size_t size, void* udata) {
+    if (!ptr) return _tracking_alloc(size, udata);
+    tracking_t* tracker = ((tracking_tag*)udata)->tracker;
+    tracking_header* hdr = (tracking_header*)ptr - 1;
+    size_t old_size = hdr->size;
+    int tag = hdr->tag;
+
+    hdr = (tracking_header*)kit_realloc(&tracker->parent, hdr, sizeof(tracking_header) + size);
+    if (!hdr) return NULL;
+    _tracking_record_realloc(&tracker->stats[tag], old_size, size);
+    _tracking_record_realloc(&tracker->total, old_size, size);
+    hdr->size = size;
+    return hdr + 1;
+}
+
+static kit_allocator _tracking_view(tracking_tag* tag) {
+    kit_allocator ret = {
+        .alloc = _tracking_alloc,
+        .realloc = _tracking_realloc,
+        .free = _tracking_free,
+        .alloc_aligned = _tracking_alloc_aligned,
+        .free_aligned = _tracking_free_aligned,
+        .free_sized = _tracking_free_sized,
+        .udata = tag
+    };
+    return ret;
+}
+
+static tracking_t* _tracking_get(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata || alloc->alloc != _tracking_alloc) return NULL;
+    return ((tracking_tag*)alloc->udata)->tracker;
+}
+
+kit_allocator kit_tracking_tag(kit_allocator* tracker, const char* tag) {
+    tracking_t* tracking = _tracking_get(tracker);
+    if (!tracking || !tag) return tracker ? *tracker : (kit_allocator){0};
+
+    for (int i = 0; i < tracking->tag_count; i++) {
+        if (strcmp(tracking->stats[i].tag, tag) == 0) return _tracking_view(&tracking->tags[i]);
+    }
+    if (tracking->tag_count == KIT_TRACKING_MAX_TAGS) {
+        kit_log_warn("Out of tracking tags, recording '%s' as '%s'", tag, tracking->stats[0].tag);
+        return _tracking_view(&tracking->tags[0]);
+    }
+    int index = tracking->tag_count++;
+    tracking->tags[index] = (tracking_tag){ tracking, index };
+    tracking->stats[index].tag = tag;
+    return _tracking_view(&tracking->tags[index]);
+}
+
+int kit_tracking_tag_count(kit_allocator* tracker) {
+    tracking_t* tracking = _tracking_get(tracker);
+    return tracking ? tracking->tag_count : 0;
+}
+
+kit_tracking_stats kit_tracking_get_stats(kit_allocator* tracker, int tag) {
+    tracking_t* tracking = _tracking_get(tracker);
+    if (!tracking || tag < 0 || tag >= tracking->tag_count) return (kit_tracking_stats){0};
+    return tracking->stats[tag];
+}
+
+kit_tracking_stats kit_tracking_get_total(kit_allocator* tracker) {
+    tracking_t* tracking = _tracking_get(tracker);
+    return tracking ? tracking->total : (kit_tracking_stats){0};
+}
+
+void kit_tracking_report(kit_allocator* tracker) {
+    tracking_t* tracking = _tracking_get(tracker);
+    if (!tracking) return;
+    kit_log_info("Memory: %zu bytes live in %zu allocations, peak %zu bytes, %zu allocations and %zu reallocations total",
+        tracking->total.live_bytes, tracking->total.live_allocs, tracking->total.peak_bytes, tracking->total.total_allocs, tracking->total.total_reallocs);
+    for (int i = 0; i < tracking->tag_count; i++) {
+        kit_tracking_stats* stats = &tracking->stats[i];
+        if (stats->live_allocs) {
+            kit_log_warn("Memory leak in '%s': %zu bytes in %zu allocations", stats->tag, stats->live_bytes, stats->live_allocs);
+        } else {
+            kit_log_debug("Memory '%s': peak %zu bytes, %zu allocations, %zu reallocations", stats->tag, stats->peak_bytes, stats->total_allocs, stats->total_reallocs);
+        }
+    }
+}
+
+void kit_release_tracking(kit_allocator* tracker) {
+    tracking_t* tracking = _tracking_get(tracker);
+    if (!tracking) return;
+    kit_tracking_report(tracker);
+    kit_allocator parent = tracking->parent;
+    kit_free(&parent, tracking);
+    *tracker = (kit_allocator){0};
+}
+
+kit_allocator kit_tracking_allocator(kit_allocator* alloc) {
+    if (!alloc) return (kit_allocator){0};
+    tracking_t* tracking = (tracking_t*)kit_alloc(alloc, sizeof(tracking_t));
+    if (!tracking) return (kit_allocator){0};
+    memset(tracking, 0, sizeof(tracking_t));
+    tracking->parent = *alloc;
+    tracking->total.tag = "total";
+    tracking->tag_count = 1;
+    tracking->tags[0] = (tracking_tag){ tracking, 0 };
+    tracking->stats[0].tag = "untagged";
+    return _tracking_view(&tracking->tags[0]);
+}
+
+//SLAB
+
+#ifndef KIT_SLAB_SIZE
+#define KIT_SLAB_SIZE (64 * 1024)
+#endif
+
+#define SLAB_CLASS_COUNT 14
+//slabs are carved from chunks of this many, a parent without cheap aligned allocations pays its padding once per chunk
+#define SLAB_CHUNK_SLABS 16
+
+static const uint32_t _slab_class_sizes[SLAB_CLASS_COUNT] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048
+};
+
+//the descriptor sits behind the last slab of the chunk
+typedef struct slab_chunk {
+    struct slab_chunk* next;
+    struct slab_chunk* prev;
+    uint32_t carved; //slabs handed out so far
+    uint32_t idle;   //carved slabs on the empty list
+} slab_chunk;
+
+//slabs are aligned to KIT_SLAB_SIZE, so the header of any pointer is found by masking its address
+typedef struct slab {
+    struct slab* next;
+    struct slab* prev;
+    slab_chunk* chunk;
+    void* free_list;
+    char* bump;
+    uint32_t used;
+    uint32_t capacity;
+    int size_class;
+} slab;
+
+//large blocks come straight from the parent with this header in front of the pointer
+typedef struct {
+    void* base;
+    size_t size;
+} slab_large;
+
+typedef struct {
+    slab* partial;
+    slab* full;
+} slab_class;
+
+typedef struct {
+    kit_allocator parent;
+    slab_class classes[SLAB_CLASS_COUNT];
+    slab_chunk* chunks;
+    slab* empty; //slabs of any class ready for reuse
+    //open addressed set of large pointers, a pointer that is not in it belongs to a slab
+    void** large;
+    size_t large_count;
+    size_t large_capacity;
+} slab_t;
+
+#define SLAB_HEADER _align_forward(sizeof(slab), 64)
+
+static int _slab_size_class(size_t size) {
+    if (size <= 16) return 0;
+    int k = _fls_size(size - 1);
+    if (k == 4) return 1;
+    return 2 + (k - 5) * 2 + (int)(((size - 1) >> (k - 1)) & 1);
+}
+
+static slab* _slab_of(void* ptr) {
+    return (slab*)((size_t)ptr & ~((size_t)KIT_SLAB_SIZE - 1));
+}
+
+static void _slab_link(slab** list, slab* s) {
+    s->prev = NULL;
+    s->next = *list;
+    if (*list) (*list)->prev = s;
+    *list = s;
+}
+
+static void _slab_unlink(slab** list, slab* s) {
+    if (s->prev) s->prev->next = s->next;
+    else *list = s->next;
+    if (s->next) s->next->prev = s->prev;
+    s->next = s->prev = NULL;
+}
+
+static size_t _slab_large_hash(void* ptr, size_t mask) {
+    return (size_t)(((uint64_t)(size_t)ptr >> 4) * 0x9E3779B97F4A7C15ull >> 32) & mask;
+}
+
+static slab_large* _slab_large_of(void* ptr) {
+    return (slab_large*)ptr - 1;
+}
+
+//returns the slot of ptr in the large set, or NULL for slab pointers
+static void** _slab_large_find(slab_t* slabs, void* ptr) {
+    if (!slabs->large_count) return NULL;
+    size_t mask = slabs->large_capacity - 1;
+    for (size_t i = _slab_large_hash(ptr, mask);; i = (i + 1) & mask) {
+        if (slabs->large[i] == ptr) return &slabs->large[i];
+        if (!slabs->large[i]) return NULL;
+    }
+}
+
+static bool _slab_large_insert(slab_t* slabs, void* ptr) {
+    if ((slabs->large_count + 1) * 2 > slabs->large_capacity) {
+        size_t capacity = slabs->large_capacity ? slabs->large_capacity * 2 : 16;
+        void** large = (void**)kit_alloc(&slabs->parent, capacity * sizeof(void*));
+        if (!large) return false;
+        memset(large, 0, capacity * sizeof(void*));
+        for (size_t i = 0; i < slabs->large_capacity; i++) {
+            if (!slabs->large[i]) continue;
+            size_t j = _slab_large_hash(slabs->large[i], capacity - 1);
+            while (large[j]) j = (j + 1) & (capacity - 1);
+            large[j] = slabs->large[i];
+        }
+        if (slabs->large) kit_free_sized(&slabs->parent, slabs->large, slabs->large_capacity * sizeof(void*));
+        slabs->large = large;
+        slabs->large_capacity = capacity;
+    }
+    size_t mask = slabs->large_capacity - 1;
+    size_t i = _slab_large_hash(ptr, mask);
+    while (slabs->large[i]) i = (i + 1) & mask;
+    slabs->large[i] = ptr;
+    slabs->large_count++;
+    return true;
+}
+
+static void _slab_large_remove(slab_t* slabs, void** slot) {
+    //backward shift keeps probe chains intact without tombstones
+    size_t mask = slabs->large_capacity - 1;
+    size_t i = (size_t)(slot - slabs->large);
+    for (size_t j = (i + 1) & mask; slabs->large[j]; j = (j + 1) & mask) {
+        size_t home = _slab_large_hash(slabs->large[j], mask);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            slabs->large[i] = slabs->large[j];
+            i = j;
+        }
+    }
+    slabs->large[i] = NULL;
+    slabs->large_count--;
+}
+
+static void* _slab_alloc_large(slab_t* slabs, size_t size, size_t align) {
+    if (align < 16) align = 16;
+    size_t offset = _align_forward(sizeof(slab_large), align);
+    char* base = (char*)kit_alloc_aligned(&slabs->parent, offset + size, align);
+    if (!base) return NULL;
+    void* ret = base + offset;
+    if (!_slab_large_insert(slabs, ret)) {
+        kit_free_aligned(&slabs->parent, base);
+        return NULL;
+    }
+    *_slab_large_of(ret) = (slab_large){ base, size };
+    return ret;
+}
+
+#define SLAB_CHUNK_BYTES ((size_t)SLAB_CHUNK_SLABS * KIT_SLAB_SIZE)
+
+static char* _slab_chunk_base(slab_chunk* chunk) {
+    return (char*)chunk - SLAB_CHUNK_BYTES;
+}
+
+static slab* _slab_new(slab_t* slabs) {
+    slab* s = slabs->empty;
+    if (s) {
+        _slab_unlink(&slabs->empty, s);
+        s->chunk->idle--;
+        return s;
+    }
+    slab_chunk* chunk = slabs->chunks;
+    if (!chunk || chunk->carved == SLAB_CHUNK_SLABS) {
+        char* base = (char*)kit_alloc_aligned(&slabs->parent, SLAB_CHUNK_BYTES + sizeof(slab_chunk), KIT_SLAB_SIZE);
+        if (!base) return NULL;
+        chunk = (slab_chunk*)(base + SLAB_CHUNK_BYTES);
+        *chunk = (slab_chunk){0};
+        //the chunk being carved stays at the front
+        chunk->next = slabs->chunks;
+        if (slabs->chunks) slabs->chunks->prev = chunk;
+        slabs->chunks = chunk;
+    }
+    s = (slab*)(_slab_chunk_base(chunk) + (size_t)chunk->carved++ * KIT_SLAB_SIZE);
+    s->chunk = chunk;
+    return s;
+}
+
+//empty slabs are kept for any class, a chunk goes back to the parent once all its slabs are empty
+static void _slab_retire(slab_t* slabs, slab* s) {
+    slab_chunk* chunk = s->chunk;
+    _slab_link(&slabs->empty, s);
+    if (++chunk->idle < chunk->carved || (chunk == slabs->chunks && chunk->carved < SLAB_CHUNK_SLABS)) return;
+
+    for (uint32_t i = 0; i < chunk->carved; i++) {
+        _slab_unlink(&slabs->empty, (slab*)(_slab_chunk_base(chunk) + (size_t)i * KIT_SLAB_SIZE));
+    }
+    if (chunk->prev) chunk->prev->next = chunk->next;
+    else slabs->chunks = chunk->next;
+    if (chunk->next) chunk->next->prev = chunk->prev;
+    kit_free_aligned(&slabs->parent, _slab_chunk_base(chunk));
+}
+
+static void* _slab_alloc(size_t size, void* udata) {
+    slab_t* slabs = (slab_t*)udata;
+    if (size > _slab_class_sizes[SLAB_CLASS_COUNT - 1]) return _slab_alloc_large(slabs, size, 16);
+
+    int c = _slab_size_class(size);
+    slab_class* cls = &slabs->classes[c];
+    slab* s = cls->partial;
+    if (!s) {
+        s = _slab_new(slabs);
+        if (!s) return NULL;
+        slab_chunk* chunk = s->chunk;
+        memset(s, 0, sizeof(slab));
+        s->chunk = chunk;
+        s->size_class = c;
+        s->bump = (char*)s + SLAB_HEADER;
+        s->capacity = (uint32_t)((KIT_SLAB_SIZE - SLAB_HEADER) / _slab_class_sizes[c]);
+        _slab_link(&cls->partial, s);
+    }
+
+    void* ret;
+    if (s->free_list) {
+        ret = s->free_list;
+        s->free_list = *(void**)ret;
+    } else {
+        //fresh slabs are carved lazily instead of threading every object up front
+        ret = s->bump;
+        s->bump += _slab_class_sizes[c];
+    }
+    if (++s->used == s->capacity) {
+        _slab_unlink(&cls->partial, s);
+        _slab_link(&cls->full, s);
+    }
+    return ret;
+}
+
+static void _slab_free(void* ptr, void* udata) {
+    slab_t* slabs = (slab_t*)udata;
+    if (!ptr) return;
+    void** large = _slab_large_find(slabs, ptr);
+    if (large) {
+        _slab_large_remove(slabs, large);
+        kit_free_aligned(&slabs->parent, _slab_large_of(ptr)->base);
+        return;
+    }
+
+    slab* s = _slab_of(ptr);
+
+    slab_class* cls = &slabs->classes[s->size_class];
+    if (s->used == s->capacity) {
+        _slab_unlink(&cls->full, s);
+        _slab_link(&cls->partial, s);
+    }
+    *(void**)ptr = s->free_list;
+    s->free_list = ptr;
+
+    //one empty slab is kept per class to avoid thrashing
+    if (--s->used == 0 && (s->prev || s->next)) {
+        _slab_unlink(&cls->partial, s);
+        _slab_retire(slabs, s);
+    }
+}
+
+static void _slab_free_sized(void* ptr, size_t size, void* udata) {
+    //the size is only checked, the slab header already knows the class
+    KIT_ASSERT(!ptr || _slab_large_find((slab_t*)udata, ptr) || size <= _slab_class_sizes[_slab_of(ptr)->size_class]);
+    (void)size;
+    _slab_free(ptr, udata);
+}
+
+static void* _slab_alloc_aligned(size_t size, size_t align, void* udata) {
+    if (align <= 16) return _slab_alloc(size, udata);
+    return _slab_alloc_large((slab_t*)udata, size, align);
+}
+
+static void* _slab_realloc(void* ptr, size_t size, void* udata) {
+    if (!ptr) return _slab_alloc(size, udata);
+    if (size == 0) {
+        _slab_free(ptr, udata);
+        return NULL;
+    }
+    bool large = _slab_large_find((slab_t*)udata, ptr) != NULL;
+    size_t old_size = large ? _slab_large_of(ptr)->size : _slab_class_sizes[_slab_of(ptr)->size_class];
+    if (!large && size <= old_size) return ptr;
+
+    void* ret = _slab_alloc(size, udata);
+    if (ret) {
+        memcpy(ret, ptr, old_size < size ? old_size : size);
+        _slab_free(ptr, udata);
+    }
+    return ret;
+}
+
+static void _slab_free_all(void* udata) {
+    slab_t* slabs = (slab_t*)udata;
+    while (slabs->chunks) {
+        slab_chunk* next = slabs->chunks->next;
+        kit_free_aligned(&slabs->parent, _slab_chunk_base(slabs->chunks));
+        slabs->chunks = next;
+    }
+    slabs->empty = NULL;
+    for (size_t i = 0; i < slabs->large_capacity; i++) {
+        if (slabs->large[i]) kit_free_aligned(&slabs->parent, _slab_large_of(slabs->large[i])->base);
+    }
+    if (slabs->large) kit_free_sized(&slabs->parent, slabs->large, slabs->large_capacity * sizeof(void*));
+    memset(slabs->classes, 0, sizeof(slabs->classes));
+    slabs->large = NULL;
+    slabs->large_count = slabs->large_capacity = 0;
+}
+
+void kit_release_slab(kit_allocator* alloc) {
+    if (!alloc || !alloc->udata) return;
+    slab_t* slabs = (slab_t*)alloc->udata;
+    _slab_free_all(slabs);
+    kit_allocator parent = slabs->parent;
+    kit_free(&parent, slabs);
+    *alloc = (kit_allocator){0};
+}
+
+kit_allocator kit_slab_allocator(kit_allocator* alloc) {
+    if (!alloc) return (kit_allocator){0};
+    slab_t* slabs = (slab_t*)kit_alloc(alloc, sizeof(slab_t));
+    if (!slabs) return (kit_allocator){0};
+    memset(slabs, 0, sizeof(slab_t));
+    slabs->parent = *alloc;
+    kit_allocator ret = {
+        .alloc = _slab_alloc,
+        .realloc = _slab_realloc,
+        .free = _slab_free,
+        .alloc_aligned = _slab_alloc_aligned,
+        .free_aligned = _slab_free,
+        .free_sized = _slab_free_sized,
+        .free_all = _slab_free_all,
+        .udata = slabs
+    };
+    return ret;
+}
@@ -1,5 +1,6 @@
 #include "deps/hmm.h"
 #include "kit.h"
+#include "kit_internal.h"
 #include "deps/m3d.h"
 #include <string.h>
 
@@ -35,7 +36,7 @@ bool kit_load_skeleton(kit_allocator* alloc, kit_skeleton* skel, kit_m3d_data* m
         KIT_ASSERT(skel->bones);
         memset(skel->bones, 0, sizeof(kit_bone) * skel->bone_count);
 
-        skel->bind_poses = kit_alloc(alloc, skel->bone_count * sizeof(kit_transform));
+        skel->bind_poses = kit_alloc_aligned(alloc, skel->bone_count * sizeof(kit_transform), KIT_SIMD_ALIGN);
         KIT_ASSERT(skel->bind_poses);
         memset(skel->bind_poses, 0, sizeof(kit_transform) * skel->bone_count);
 
@@ -81,10 +82,10 @@ bool kit_load_skeleton(kit_allocator* alloc, kit_skeleton* skel, kit_m3d_data* m
 void kit_release_skeleton(kit_allocator* alloc, kit_skeleton* skel) {
     KIT_ASSERT(skel);
     if(skel->bind_poses) {
-        kit_free(alloc, skel->bind_poses);
+        kit_free_aligned(alloc, skel->bind_poses);
     }
     if(skel->bones) {
-        kit_free(alloc, skel->bones);
+        kit_free_sized(alloc, skel->bones, skel->bone_count * sizeof(kit_bone));
     }
 }
 
@@ -98,6 +99,10 @@ kit_bone_anim_data* kit_load_bone_anims(kit_allocator* alloc, kit_m3d_data* m3d,
     memset(anims, 0, m3d->numaction * sizeof(kit_bone_anim_data));
     *count = m3d->numaction;
 
+    //m3d_pose is only asked for exact keyframe times, so it never reallocates the model
+    //and its temporary pose can come from alloc
+    kit_allocator* prev_alloc = _kit_push_dep_allocator(alloc);
+
     for (unsigned int a = 0; a < m3d->numaction; a++) {
         anims[a].bone_count = m3d->numbone + 1;
         anims[a].bones = kit_alloc(alloc, (m3d->numbone + 1) * sizeof(kit_bone));
@@ -117,7 +122,7 @@ kit_bone_anim_data* kit_load_bone_anims(kit_allocator* alloc, kit_m3d_data* m3d,
         anims[a].keyframes = kit_alloc(alloc, keyframe_count * sizeof(kit_bone_keyframe));
         for (int k = 0; k < keyframe_count; k++) {
             anims[a].keyframes[k].time = (float)m3d->action[a].frame[k].msec;
-            anims[a].keyframes[k].pose = kit_alloc(alloc, (m3d->numbone + 1) * sizeof(kit_transform));
+            anims[a].keyframes[k].pose = kit_alloc_aligned(alloc, (m3d->numbone + 1) * sizeof(kit_transform), KIT_SIMD_ALIGN);
             m3db_t* pose = m3d_pose(m3d, a, m3d->action[a].frame[k].msec);
             if (pose != NULL) {
                 for (j = 0; j < (int)m3d->numbone; j++) {
@@ -145,6 +150,7 @@ kit_bone_anim_data* kit_load_bone_anims(kit_allocator* alloc, kit_m3d_data* m3d,
             }
         }
     }
+    _kit_pop_dep_allocator(prev_alloc);
     return anims;
 }
 
@@ -229,13 +235,13 @@ void kit_release_bone_anim(kit_allocator* alloc,kit_bone_anim_data* anim) {
     if (anim->keyframes) {
         for (int i = 0; i < anim->keyframe_count; ++i) {
             if (anim->keyframes[i].pose) {
-                kit_free(alloc, anim->keyframes[i].pose);
+                kit_free_aligned(alloc, anim->keyframes[i].pose);
             }
         }
-        kit_free(alloc, anim->keyframes);
+        kit_free_sized(alloc, anim->keyframes, anim->keyframe_count * sizeof(kit_bone_keyframe));
     }
 
     if (anim->bones) {
-        kit_free(alloc, anim->bones);
+        kit_free_sized(alloc, anim->bones, anim->bone_count * sizeof(kit_bone));
     }
 }
\ No newline at end of file
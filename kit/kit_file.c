@@ -1,6 +1,25 @@
 #include "kit.h"
+#include "kit_internal.h"
 #include <stdio.h>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//io_uring for kit_read_file_async on linux, define KIT_FILE_NO_URING to only use the thread pool
+#if defined(__linux__) && !defined(KIT_FILE_NO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define _KIT_FILE_URING
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
 kit_memory kit_read_file(kit_allocator *alloc, const char *path, bool null_terminate, kit_file_error *err) {
     if (!alloc || !path || !err) return (kit_memory){0};
 
@@ -33,4 +52,773 @@ kit_memory kit_read_file(kit_allocator *alloc, const char *path, bool null_termi
     result.size = filesize;
     kit_log_trace("Loaded file: %s (%ld bytes)", path, filesize);
     return result;
-}
\ No newline at end of file
+}
+
+kit_memory kit_map_file(const char* path, kit_file_error* err) {
+    if (!path || !err) return (kit_memory){0};
+
+    kit_memory result = {0};
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        *err = KIT_FILE_ERROR_NOT_FOUND;
+        kit_log_error("Failed to open file: %s", path);
+        return result;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        *err = KIT_FILE_ERROR_IO;
+        kit_log_error("Failed to map empty file: %s", path);
+        return result;
+    }
+    //the view keeps the mapping and the file open
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* ptr = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    if (!ptr) {
+        *err = KIT_FILE_ERROR_IO;
+        kit_log_error("Failed to map file: %s", path);
+        return result;
+    }
+    result.ptr = (uint8_t*)ptr;
+    result.size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        *err = KIT_FILE_ERROR_NOT_FOUND;
+        kit_log_error("Failed to open file: %s", path);
+        return result;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        *err = KIT_FILE_ERROR_IO;
+        kit_log_error("Failed to map empty file: %s", path);
+        return result;
+    }
+    void* ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        *err = KIT_FILE_ERROR_IO;
+        kit_log_error("Failed to map file: %s", path);
+        return result;
+    }
+    //loaders parse front to back, read ahead aggressively and drop pages behind
+    madvise(ptr, (size_t)st.st_size, MADV_SEQUENTIAL);
+    madvise(ptr, (size_t)st.st_size, MADV_WILLNEED);
+    result.ptr = (uint8_t*)ptr;
+    result.size = (size_t)st.st_size;
+#endif
+
+    *err = KIT_FILE_ERROR_NONE;
+    kit_log_trace("Mapped file: %s (%zu bytes)", path, result.size);
+    return result;
+}
+
+void kit_unmap_file(kit_memory* mem) {
+    if (!mem || !mem->ptr) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(mem->ptr);
+#else
+    munmap(mem->ptr, mem->size);
+#endif
+    *mem = (kit_memory){0};
+}
+
+//ASYNC
+
+#define FILE_IO_CHUNK_SIZE (1024 * 1024)
+#define FILE_IO_PRIORITIES 3
+
+struct kit_file_request {
+    struct kit_file_request* next;
+    char* path;
+    kit_allocator owner; //the pool's allocator the request came from
+    kit_allocator alloc; //for the data
+    kit_file_callback callback;
+    void* udata;
+    kit_file_priority priority;
+    bool null_terminate;
+    volatile uint32_t status;
+    volatile uint32_t cancel;
+    bool completing;     //set once a cancel can't stop the read anymore
+    kit_memory mem;
+    kit_file_error err;
+};
+
+typedef struct {
+    kit_allocator alloc; //for the requests
+    _kit_mutex mutex;
+    _kit_cond work;      //signaled when a request is queued
+    _kit_cond done;      //broadcast when a request reaches a final status
+    struct kit_file_request* head[FILE_IO_PRIORITIES];
+    struct kit_file_request* tail[FILE_IO_PRIORITIES];
+    bool stop;
+    uint32_t thread_count;
+    uint32_t pool_size;  //threads of the pool, also when io_uring falls back to it
+    _kit_thread* threads;
+    kit_file_io_backend backend;
+#if defined(_KIT_FILE_URING)
+    struct _kit_uring* uring;
+    struct _uring_slot* slots;
+    uint32_t queue_depth;
+#endif
+} _kit_file_io;
+
+static _kit_file_io* _kit_file_io_state;
+//the request whose callback runs on this thread and the status it gets once the callback returns
+static KIT_THREAD_LOCAL struct kit_file_request* _file_callback_req;
+static KIT_THREAD_LOCAL kit_file_status _file_callback_status;
+
+static bool _file_status_final(uint32_t status) {
+    return status >= KIT_FILE_STATUS_DONE;
+}
+
+//the callback sees its request as finished, everyone else only after it returned
+static uint32_t _file_status(struct kit_file_request* req) {
+    if (req == _file_callback_req) return _file_callback_status;
+    return _kit_atomic_load_u32(&req->status);
+}
+
+static struct kit_file_request* _file_queue_pop(_kit_file_io* io) {
+    for (int p = FILE_IO_PRIORITIES - 1; p >= 0; p--) {
+        struct kit_file_request* req = io->head[p];
+        if (!req) continue;
+        io->head[p] = req->next;
+        if (!io->head[p]) io->tail[p] = NULL;
+        req->next = NULL;
+        return req;
+    }
+    return NULL;
+}
+
+static bool _file_queue_remove(_kit_file_io* io, struct kit_file_request* req) {
+    int p = req->priority - KIT_FILE_PRIORITY_LOW;
+    struct kit_file_request* prev = NULL;
+    for (struct kit_file_request* it = io->head[p]; it; prev = it, it = it->next) {
+        if (it != req) continue;
+        if (prev) prev->next = it->next;
+        else io->head[p] = it->next;
+        if (io->tail[p] == it) io->tail[p] = prev;
+        it->next = NULL;
+        return true;
+    }
+    return false;
+}
+
+//like kit_read_file, in chunks so a cancel doesn't wait for the whole file
+static void _file_read(struct kit_file_request* req) {
+    FILE* file = fopen(req->path, "rb");
+    if (!file) {
+        req->err = KIT_FILE_ERROR_NOT_FOUND;
+        kit_log_error("Failed to open file: %s", req->path);
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    long filesize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (filesize < 0) {
+        fclose(file);
+        req->err = KIT_FILE_ERROR_IO;
+        kit_log_error("Failed to read file: %s", req->path);
+        return;
+    }
+
+    uint8_t* ptr = (uint8_t*)kit_alloc(&req->alloc, (size_t)filesize + 1);
+    if (!ptr) {
+        fclose(file);
+        req->err = KIT_FILE_ERROR_NOMEM;
+        kit_log_error("Failed to allocate memory for file: %s", req->path);
+        return;
+    }
+
+    size_t done = 0;
+    while (done < (size_t)filesize && !_kit_atomic_load_u32(&req->cancel)) {
+        size_t chunk = (size_t)filesize - done;
+        if (chunk > FILE_IO_CHUNK_SIZE) chunk = FILE_IO_CHUNK_SIZE;
+        size_t read = fread(ptr + done, 1, chunk, file);
+        done += read;
+        if (read < chunk) break;
+    }
+    fclose(file);
+
+    if (done < (size_t)filesize) {
+        kit_free_sized(&req->alloc, ptr, (size_t)filesize + 1);
+        if (!_kit_atomic_load_u32(&req->cancel)) {
+            req->err = KIT_FILE_ERROR_IO;
+            kit_log_error("Failed to read file: %s", req->path);
+        }
+        return;
+    }
+    if (req->null_terminate) ptr[filesize] = '\0';
+    req->mem = (kit_memory){ ptr, (size_t)filesize };
+    kit_log_trace("Loaded file: %s (%ld bytes)", req->path, filesize);
+}
+
+static void _file_finish(_kit_file_io* io, struct kit_file_request* req, kit_file_status status) {
+    _kit_mutex_lock(&io->mutex);
+    _kit_atomic_store_u32(&req->status, status);
+    _kit_cond_broadcast(&io->done);
+    _kit_mutex_unlock(&io->mutex);
+}
+
+//runs the callback and publishes the status once the read left mem and err behind
+static void _file_complete(_kit_file_io* io, struct kit_file_request* req) {
+    _kit_mutex_lock(&io->mutex);
+    bool cancelled = _kit_atomic_load_u32(&req->cancel) != 0;
+    req->completing = !cancelled;
+    _kit_mutex_unlock(&io->mutex);
+    if (cancelled) {
+        if (req->mem.ptr) kit_free_sized(&req->alloc, req->mem.ptr, req->mem.size + 1);
+        req->mem = (kit_memory){0};
+        _file_finish(io, req, KIT_FILE_STATUS_CANCELLED);
+        return;
+    }
+    kit_file_status status = req->mem.ptr ? KIT_FILE_STATUS_DONE : KIT_FILE_STATUS_FAILED;
+    if (req->callback) {
+        _file_callback_req = req;
+        _file_callback_status = status;
+        req->callback(req, req->udata);
+        _file_callback_req = NULL;
+    }
+    _file_finish(io, req, status);
+}
+
+static _KIT_THREAD_PROC(_file_io_worker) {
+    _kit_file_io* io = (_kit_file_io*)arg;
+    for (;;) {
+        _kit_mutex_lock(&io->mutex);
+        struct kit_file_request* req = NULL;
+        while (!io->stop && !(req = _file_queue_pop(io))) _kit_cond_wait(&io->work, &io->mutex);
+        if (req) _kit_atomic_store_u32(&req->status, KIT_FILE_STATUS_RUNNING);
+        _kit_mutex_unlock(&io->mutex);
+        if (!req) break;
+
+        _file_read(req);
+        _file_complete(io, req);
+    }
+    return 0;
+}
+
+#if defined(_KIT_FILE_URING)
+//IO_URING
+//one io thread keeps up to queue_depth reads in flight. each one is an openat and a statx in the same batch,
+//chunked reads and a close, every turn submits the new operations and reaps all completions in one syscall.
+
+enum {
+    URING_OPEN,
+    URING_STATX,
+    URING_READ,
+    URING_CLOSE,
+};
+
+typedef struct _kit_uring {
+    int fd;
+    uint32_t entries;
+    volatile uint32_t* sq_head;
+    volatile uint32_t* sq_tail;
+    uint32_t sq_mask;
+    uint32_t* sq_array;
+    volatile uint32_t* cq_head;
+    volatile uint32_t* cq_tail;
+    uint32_t cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    uint32_t sqe_tail;  //next entry to fill
+    uint32_t submitted; //entries handed to the kernel
+} _kit_uring;
+
+typedef struct _uring_slot {
+    struct kit_file_request* req;
+    int fd;
+    int open_res;
+    int statx_res;
+    bool fd_open;     //open finished and no close was queued yet
+    uint32_t pending; //operations in flight
+    uint8_t* ptr;
+    size_t size;
+    size_t done;
+    struct statx stx;
+} _uring_slot;
+
+static bool _uring_supported(int fd) {
+    uint64_t buffer[(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op)) / sizeof(uint64_t) + 1];
+    memset(buffer, 0, sizeof(buffer));
+    struct io_uring_probe* probe = (struct io_uring_probe*)buffer;
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0) return false;
+    const int ops[] = { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (ops[i] > probe->last_op || !(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED)) return false;
+    }
+    return true;
+}
+
+static void _uring_destroy(_kit_uring* r) {
+    if (r->sqes) munmap(r->sqes, r->sqes_size);
+    if (r->cq_ring && r->cq_ring != r->sq_ring) munmap(r->cq_ring, r->cq_ring_size);
+    if (r->sq_ring) munmap(r->sq_ring, r->sq_ring_size);
+    close(r->fd);
+}
+
+//false if the kernel has no io_uring, forbids it or lacks one of the operations
+static bool _uring_init(_kit_uring* r, uint32_t entries) {
+    memset(r, 0, sizeof(_kit_uring));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (r->fd < 0) return false;
+    if (!_uring_supported(r->fd)) {
+        close(r->fd);
+        return false;
+    }
+
+    r->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    r->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && r->cq_ring_size > r->sq_ring_size) r->sq_ring_size = r->cq_ring_size;
+    r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_ring == MAP_FAILED) {
+        r->sq_ring = NULL;
+        _uring_destroy(r);
+        return false;
+    }
+    r->cq_ring = single ? r->sq_ring :
+        mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+    if (r->cq_ring == MAP_FAILED) {
+        r->cq_ring = NULL;
+        _uring_destroy(r);
+        return false;
+    }
+    r->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = (struct io_uring_sqe*)mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) {
+        r->sqes = NULL;
+        _uring_destroy(r);
+        return false;
+    }
+
+    uint8_t* sq = (uint8_t*)r->sq_ring;
+    uint8_t* cq = (uint8_t*)r->cq_ring;
+    r->entries = params.sq_entries;
+    r->sq_head = (volatile uint32_t*)(sq + params.sq_off.head);
+    r->sq_tail = (volatile uint32_t*)(sq + params.sq_off.tail);
+    r->sq_mask = *(uint32_t*)(sq + params.sq_off.ring_mask);
+    r->sq_array = (uint32_t*)(sq + params.sq_off.array);
+    r->cq_head = (volatile uint32_t*)(cq + params.cq_off.head);
+    r->cq_tail = (volatile uint32_t*)(cq + params.cq_off.tail);
+    r->cq_mask = *(uint32_t*)(cq + params.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    r->sqe_tail = r->submitted = *r->sq_tail;
+    return true;
+}
+
+static struct io_uring_sqe* _uring_prep(_kit_uring* r, uint8_t op, int fd, const void* addr, uint32_t len, uint64_t off, uint64_t user_data) {
+    //the ring has two entries per slot, a slot never has more in flight
+    if (r->sqe_tail - _kit_atomic_load_u32(r->sq_head) >= r->entries) return NULL;
+    uint32_t index = r->sqe_tail & r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)addr;
+    sqe->len = len;
+    sqe->off = off;
+    sqe->user_data = user_data;
+    r->sq_array[index] = index;
+    r->sqe_tail++;
+    return sqe;
+}
+
+static uint32_t _uring_space(_kit_uring* r) {
+    return r->entries - (r->sqe_tail - _kit_atomic_load_u32(r->sq_head));
+}
+
+//submits everything prepared and waits for at least one completion, false if the ring is unusable
+static bool _uring_enter(_kit_uring* r) {
+    _kit_atomic_store_u32(r->sq_tail, r->sqe_tail);
+    for (;;) {
+        long ret = syscall(__NR_io_uring_enter, r->fd, r->sqe_tail - r->submitted, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (ret >= 0) {
+            r->submitted += (uint32_t)ret;
+            return true;
+        }
+        if (errno != EINTR) {
+            kit_log_error("io_uring_enter failed: %d", errno);
+            return false;
+        }
+    }
+}
+
+#define URING_DATA(slot, op) (((uint64_t)(slot) << 8) | (op))
+
+//closes through the ring, or right away when it has no room. true if the request is finished.
+static bool _uring_close(_kit_uring* r, _uring_slot* s, uint32_t index) {
+    if (s->ptr && !s->req->mem.ptr) kit_free_sized(&s->req->alloc, s->ptr, s->size + 1);
+    s->ptr = NULL;
+    s->fd_open = false;
+    if (_uring_prep(r, IORING_OP_CLOSE, s->fd, NULL, 0, 0, URING_DATA(index, URING_CLOSE))) {
+        s->pending = 1;
+        return false;
+    }
+    close(s->fd);
+    return true;
+}
+
+static bool _uring_read(_kit_uring* r, _uring_slot* s, uint32_t index) {
+    size_t chunk = s->size - s->done;
+    if (chunk > FILE_IO_CHUNK_SIZE) chunk = FILE_IO_CHUNK_SIZE;
+    if (!_uring_prep(r, IORING_OP_READ, s->fd, s->ptr + s->done, (uint32_t)chunk, s->done, URING_DATA(index, URING_READ))) return false;
+    s->pending = 1;
+    return true;
+}
+
+//advances a read by one completion, returns true once the request is finished
+static bool _uring_step(_kit_uring* r, _uring_slot* s, uint32_t index, uint32_t op, int res) {
+    struct kit_file_request* req = s->req;
+    switch (op) {
+    case URING_OPEN:
+    case URING_STATX:
+        if (op == URING_OPEN) s->open_res = res;
+        else s->statx_res = res;
+        if (--s->pending) return false;
+        if (s->open_res < 0) {
+            req->err = KIT_FILE_ERROR_NOT_FOUND;
+            kit_log_error("Failed to open file: %s", req->path);
+            return true;
+        }
+        s->fd = s->open_res;
+        s->fd_open = true;
+        if (s->statx_res < 0) {
+            req->err = KIT_FILE_ERROR_IO;
+            kit_log_error("Failed to read file: %s", req->path);
+            return _uring_close(r, s, index);
+        }
+        if (_kit_atomic_load_u32(&req->cancel)) {
+            return _uring_close(r, s, index);
+        }
+        s->size = (size_t)s->stx.stx_size;
+        s->ptr = (uint8_t*)kit_alloc(&req->alloc, s->size + 1);
+        if (!s->ptr) {
+            req->err = KIT_FILE_ERROR_NOMEM;
+            kit_log_error("Failed to allocate memory for file: %s", req->path);
+            return _uring_close(r, s, index);
+        }
+        break;
+    case URING_READ:
+        if (res <= 0) {
+            //an error, or the file got shorter since statx
+            req->err = KIT_FILE_ERROR_IO;
+            kit_log_error("Failed to read file: %s", req->path);
+            return _uring_close(r, s, index);
+        }
+        s->done += (size_t)res;
+        if (_kit_atomic_load_u32(&req->cancel)) {
+            return _uring_close(r, s, index);
+        }
+        break;
+    case URING_CLOSE:
+        return true;
+    }
+
+    if (s->done < s->size) {
+        if (_uring_read(r, s, index)) return false;
+        req->err = KIT_FILE_ERROR_IO;
+        kit_log_error("Failed to queue a read for file: %s", req->path);
+        return _uring_close(r, s, index);
+    }
+    if (req->null_terminate) s->ptr[s->size] = '\0';
+    req->mem = (kit_memory){ s->ptr, s->size };
+    kit_log_trace("Loaded file: %s (%zu bytes)", req->path, s->size);
+    return _uring_close(r, s, index);
+}
+
+//finishes every read in flight after the ring broke. data of unfinished reads is leaked,
+//the kernel may still be writing into it.
+static void _uring_fail(_kit_file_io* io) {
+    for (uint32_t i = 0; i < io->queue_depth; i++) {
+        _uring_slot* s = &io->slots[i];
+        struct kit_file_request* req = s->req;
+        if (!req) continue;
+        if (s->fd_open) close(s->fd);
+        if (!req->mem.ptr && req->err == KIT_FILE_ERROR_NONE) req->err = KIT_FILE_ERROR_IO;
+        s->req = NULL;
+        _file_complete(io, req);
+    }
+}
+
+static _KIT_THREAD_PROC(_file_io_uring) {
+    _kit_file_io* io = (_kit_file_io*)arg;
+    _kit_uring* r = io->uring;
+    uint32_t in_flight = 0;
+    for (;;) {
+        _kit_mutex_lock(&io->mutex);
+        while (!io->stop && in_flight == 0 && !(io->head[0] || io->head[1] || io->head[2])) {
+            _kit_cond_wait(&io->work, &io->mutex);
+        }
+        //requests still in flight at a stop finish, like the running reads of the thread pool
+        //a new read needs room for its openat and statx
+        for (uint32_t i = 0; i < io->queue_depth && !io->stop && _uring_space(r) >= 2; i++) {
+            _uring_slot* s = &io->slots[i];
+            if (s->req) continue;
+            struct kit_file_request* req = _file_queue_pop(io);
+            if (!req) break;
+            _kit_atomic_store_u32(&req->status, KIT_FILE_STATUS_RUNNING);
+            memset(s, 0, sizeof(_uring_slot));
+            s->req = req;
+            s->pending = 2;
+            struct io_uring_sqe* open = _uring_prep(r, IORING_OP_OPENAT, AT_FDCWD, req->path, 0, 0, URING_DATA(i, URING_OPEN));
+            struct io_uring_sqe* stat = _uring_prep(r, IORING_OP_STATX, AT_FDCWD, req->path, STATX_SIZE,
+                (uint64_t)(uintptr_t)&s->stx, URING_DATA(i, URING_STATX));
+            KIT_ASSERT(open && stat);
+            open->open_flags = O_RDONLY | O_CLOEXEC;
+            stat->statx_flags = 0;
+            in_flight++;
+        }
+        _kit_mutex_unlock(&io->mutex);
+        if (in_flight == 0) {
+            if (io->stop) break;
+            continue;
+        }
+
+        if (!_uring_enter(r)) break;
+        uint32_t head = *r->cq_head;
+        uint32_t tail = _kit_atomic_load_u32(r->cq_tail);
+        for (; head != tail; head++) {
+            struct io_uring_cqe* cqe = &r->cqes[head & r->cq_mask];
+            uint32_t index = (uint32_t)(cqe->user_data >> 8);
+            _uring_slot* s = &io->slots[index];
+            if (_uring_step(r, s, index, (uint32_t)(cqe->user_data & 0xff), cqe->res)) {
+                struct kit_file_request* req = s->req;
+                s->req = NULL;
+                in_flight--;
+                _file_complete(io, req);
+            }
+        }
+        _kit_atomic_store_u32(r->cq_head, head);
+    }
+    if (in_flight == 0) return 0;
+
+    //the ring broke, this thread and the rest of the pool take over the queue
+    _uring_fail(io);
+    kit_log_error("io_uring failed, reading files on io threads");
+    _kit_mutex_lock(&io->mutex);
+    io->backend = KIT_FILE_IO_BACKEND_THREADS;
+    while (!io->stop && io->thread_count < io->pool_size) {
+        if (!_kit_thread_start(&io->threads[io->thread_count], _file_io_worker, io)) break;
+        io->thread_count++;
+    }
+    _kit_mutex_unlock(&io->mutex);
+    return _file_io_worker(arg);
+}
+#endif
+
+static void _file_io_destroy(_kit_file_io* io) {
+    kit_allocator alloc = io->alloc;
+#if defined(_KIT_FILE_URING)
+    if (io->uring) {
+        _uring_destroy(io->uring);
+        kit_free(&alloc, io->uring);
+    }
+    if (io->slots) kit_free(&alloc, io->slots);
+#endif
+    _kit_cond_destroy(&io->done);
+    _kit_cond_destroy(&io->work);
+    _kit_mutex_destroy(&io->mutex);
+    kit_free(&alloc, io->threads);
+    kit_free(&alloc, io);
+}
+
+bool kit_file_io_start(kit_allocator* alloc, const kit_file_io_desc* desc) {
+    if (!alloc || !desc || _kit_file_io_state) return false;
+
+    uint32_t thread_count = KIT_DEF(desc->thread_count, 4);
+    _kit_file_io* io = (_kit_file_io*)kit_alloc(alloc, sizeof(_kit_file_io));
+    if (!io) return false;
+    memset(io, 0, sizeof(_kit_file_io));
+    io->threads = (_kit_thread*)kit_alloc(alloc, thread_count * sizeof(_kit_thread));
+    if (!io->threads) {
+        kit_free(alloc, io);
+        return false;
+    }
+    io->alloc = *alloc;
+    io->pool_size = thread_count;
+    io->backend = KIT_FILE_IO_BACKEND_THREADS;
+    _kit_mutex_init(&io->mutex);
+    _kit_cond_init(&io->work);
+    _kit_cond_init(&io->done);
+
+#if defined(_KIT_FILE_URING)
+    if (desc->backend != KIT_FILE_IO_BACKEND_THREADS) {
+        uint32_t depth = KIT_DEF(desc->queue_depth, 64);
+        io->uring = (_kit_uring*)kit_alloc(alloc, sizeof(_kit_uring));
+        io->slots = (_uring_slot*)kit_alloc(alloc, depth * sizeof(_uring_slot));
+        if (io->uring && io->slots && _uring_init(io->uring, 2 * depth)) {
+            memset(io->slots, 0, depth * sizeof(_uring_slot));
+            io->queue_depth = depth;
+            io->backend = KIT_FILE_IO_BACKEND_URING;
+        } else {
+            if (io->uring) kit_free(alloc, io->uring);
+            if (io->slots) kit_free(alloc, io->slots);
+            io->uring = NULL;
+            io->slots = NULL;
+            if (desc->backend == KIT_FILE_IO_BACKEND_AUTO) kit_log_info("io_uring is not available, reading files on io threads");
+        }
+    }
+#endif
+    if (desc->backend == KIT_FILE_IO_BACKEND_URING && io->backend != KIT_FILE_IO_BACKEND_URING) {
+        kit_log_error("io_uring is not available!");
+        _file_io_destroy(io);
+        return false;
+    }
+
+#if defined(_KIT_FILE_URING)
+    if (io->backend == KIT_FILE_IO_BACKEND_URING) {
+        if (_kit_thread_start(&io->threads[0], _file_io_uring, io)) io->thread_count = 1;
+    } else
+#endif
+    for (; io->thread_count < thread_count; io->thread_count++) {
+        if (!_kit_thread_start(&io->threads[io->thread_count], _file_io_worker, io)) break;
+    }
+    if (io->thread_count == 0) {
+        kit_log_error("Failed to start the file io threads!");
+        _file_io_destroy(io);
+        return false;
+    }
+    _kit_file_io_state = io;
+    return true;
+}
+
+void kit_file_io_stop(void) {
+    _kit_file_io* io = _kit_file_io_state;
+    if (!io) return;
+
+    _kit_mutex_lock(&io->mutex);
+    io->stop = true;
+    struct kit_file_request* req;
+    while ((req = _file_queue_pop(io))) _kit_atomic_store_u32(&req->status, KIT_FILE_STATUS_CANCELLED);
+    _kit_cond_broadcast(&io->work);
+    _kit_cond_broadcast(&io->done);
+    _kit_mutex_unlock(&io->mutex);
+
+    //running reads finish, nothing waits on the conditions afterwards
+    for (uint32_t i = 0; i < io->thread_count; i++) _kit_thread_join(io->threads[i]);
+    _kit_file_io_state = NULL;
+    _file_io_destroy(io);
+}
+
+kit_file_io_backend kit_file_io_get_backend(void) {
+    _kit_file_io* io = _kit_file_io_state;
+    if (!io) return KIT_FILE_IO_BACKEND_AUTO;
+    _kit_mutex_lock(&io->mutex);
+    kit_file_io_backend backend = io->backend;
+    _kit_mutex_unlock(&io->mutex);
+    return backend;
+}
+
+kit_file_handle kit_read_file_async(const char* path, kit_allocator* alloc, kit_file_callback callback, const kit_file_read_desc* desc) {
+    _kit_file_io* io = _kit_file_io_state;
+    if (!path || !alloc) return NULL;
+    if (!io) {
+        kit_log_error("kit_file_io_start must be called before kit_read_file_async!");
+        return NULL;
+    }
+    kit_file_read_desc def = {0};
+    if (!desc) desc = &def;
+    if (desc->priority < KIT_FILE_PRIORITY_LOW || desc->priority > KIT_FILE_PRIORITY_HIGH) return NULL;
+
+    size_t path_size = strlen(path) + 1;
+    _kit_mutex_lock(&io->mutex);
+    struct kit_file_request* req = (struct kit_file_request*)kit_alloc(&io->alloc, sizeof(struct kit_file_request) + path_size);
+    if (req) {
+        *req = (struct kit_file_request){
+            .path = (char*)(req + 1),
+            .owner = io->alloc,
+            .alloc = *alloc,
+            .callback = callback,
+            .udata = desc->udata,
+            .priority = desc->priority,
+            .null_terminate = desc->null_terminate,
+            .status = KIT_FILE_STATUS_PENDING,
+        };
+        memcpy(req->path, path, path_size);
+        int p = desc->priority - KIT_FILE_PRIORITY_LOW;
+        if (io->tail[p]) io->tail[p]->next = req;
+        else io->head[p] = req;
+        io->tail[p] = req;
+        _kit_cond_signal(&io->work);
+    }
+    _kit_mutex_unlock(&io->mutex);
+    return req;
+}
+
+kit_file_status kit_file_poll(kit_file_handle handle) {
+    if (!handle) return KIT_FILE_STATUS_FAILED;
+    return (kit_file_status)_file_status(handle);
+}
+
+kit_file_status kit_file_wait(kit_file_handle handle) {
+    if (!handle) return KIT_FILE_STATUS_FAILED;
+    _kit_file_io* io = _kit_file_io_state;
+    //after kit_file_io_stop every request has its final status
+    if (io && !_file_status_final(_file_status(handle))) {
+        _kit_mutex_lock(&io->mutex);
+        while (!_file_status_final(_kit_atomic_load_u32(&handle->status))) _kit_cond_wait(&io->done, &io->mutex);
+        _kit_mutex_unlock(&io->mutex);
+    }
+    return (kit_file_status)_file_status(handle);
+}
+
+bool kit_file_cancel(kit_file_handle handle) {
+    _kit_file_io* io = _kit_file_io_state;
+    if (!handle || !io) return handle && _kit_atomic_load_u32(&handle->status) == KIT_FILE_STATUS_CANCELLED;
+
+    _kit_mutex_lock(&io->mutex);
+    bool cancelled = false;
+    uint32_t status = _kit_atomic_load_u32(&handle->status);
+    if (status == KIT_FILE_STATUS_PENDING && _file_queue_remove(io, handle)) {
+        _kit_atomic_store_u32(&handle->status, KIT_FILE_STATUS_CANCELLED);
+        _kit_cond_broadcast(&io->done);
+        cancelled = true;
+    } else if (status == KIT_FILE_STATUS_RUNNING && !handle->completing) {
+        _kit_atomic_store_u32(&handle->cancel, 1);
+        cancelled = true;
+    } else {
+        cancelled = status == KIT_FILE_STATUS_CANCELLED;
+    }
+    _kit_mutex_unlock(&io->mutex);
+    return cancelled;
+}
+
+kit_memory kit_file_take(kit_file_handle handle, kit_file_error* err) {
+    if (!handle || _file_status(handle) != KIT_FILE_STATUS_DONE) {
+        if (err) *err = handle ? handle->err : KIT_FILE_ERROR_INVALID_ARGS;
+        return (kit_memory){0};
+    }
+    if (err) *err = KIT_FILE_ERROR_NONE;
+    kit_memory mem = handle->mem;
+    handle->mem = (kit_memory){0};
+    return mem;
+}
+
+void kit_file_release(kit_file_handle handle) {
+    if (!handle) return;
+    if (!_file_status_final(_kit_atomic_load_u32(&handle->status))) {
+        kit_file_cancel(handle);
+        kit_file_wait(handle);
+    }
+    if (handle->mem.ptr) kit_free_sized(&handle->alloc, handle->mem.ptr, handle->mem.size + 1);
+
+    //requests are allocated under the pool's lock, the pool may be stopped by now
+    _kit_file_io* io = _kit_file_io_state;
+    kit_allocator owner = handle->owner;
+    if (io) _kit_mutex_lock(&io->mutex);
+    kit_free_sized(&owner, handle, sizeof(struct kit_file_request) + strlen(handle->path) + 1);
+    if (io) _kit_mutex_unlock(&io->mutex);
+}
@@ -324,18 +324,18 @@ kit_image_data kit_load_image_data(kit_allocator* alloc, const char* path, uint1
     kit_image_data img = {0};
     if (!alloc || !path || !err) return img;
 
-    kit_memory mem = kit_read_file(alloc, path, true, err);
+    kit_memory mem = kit_map_file(path, err);
     if (!mem.ptr || mem.size == 0) {
         kit_log_error("Failed to read image file: %s, err: %d", path, *err);
         return img;
     }
 
     img = kit_load_image_data_mem(alloc, &mem, channel_count);
-    kit_free(alloc, mem.ptr);
+    kit_unmap_file(&mem);
     return img;
 }
 
-void kit_release_image(kit_allocator* alloc, kit_image_data* img) {
+void kit_release_image_data(kit_allocator* alloc, kit_image_data* img) {
     if (!alloc || !img) return;
     if (img->data) {
         kit_free(alloc, img->data);
@@ -0,0 +1,240 @@
+#pragma once
+//Helpers shared by the kit implementation files, not part of the public api.
+
+#include "kit.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+//--ATOMICS---------------------------------------------------------
+//sequentially consistent on gcc/clang, full barriers through the Interlocked intrinsics on msvc
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static inline uint32_t _kit_atomic_load_u32(volatile uint32_t* p) {
+    return (uint32_t)_InterlockedOr((volatile long*)p, 0);
+}
+
+static inline void _kit_atomic_store_u32(volatile uint32_t* p, uint32_t v) {
+    _InterlockedExchange((volatile long*)p, (long)v);
+}
+
+static inline uint32_t _kit_atomic_add_u32(volatile uint32_t* p, uint32_t v) {
+    return (uint32_t)_InterlockedExchangeAdd((volatile long*)p, (long)v);
+}
+
+static inline bool _kit_atomic_cas_u32(volatile uint32_t* p, uint32_t* expected, uint32_t desired) {
+    uint32_t prev = (uint32_t)_InterlockedCompareExchange((volatile long*)p, (long)desired, (long)*expected);
+    if (prev == *expected) return true;
+    *expected = prev;
+    return false;
+}
+
+static inline uint64_t _kit_atomic_load_u64(volatile uint64_t* p) {
+    return (uint64_t)_InterlockedCompareExchange64((volatile __int64*)p, 0, 0);
+}
+
+static inline void _kit_atomic_store_u64(volatile uint64_t* p, uint64_t v) {
+    uint64_t prev = _kit_atomic_load_u64(p);
+    while (_InterlockedCompareExchange64((volatile __int64*)p, (__int64)v, (__int64)prev) != (__int64)prev) {
+        prev = _kit_atomic_load_u64(p);
+    }
+}
+
+static inline bool _kit_atomic_cas_u64(volatile uint64_t* p, uint64_t* expected, uint64_t desired) {
+    uint64_t prev = (uint64_t)_InterlockedCompareExchange64((volatile __int64*)p, (__int64)desired, (__int64)*expected);
+    if (prev == *expected) return true;
+    *expected = prev;
+    return false;
+}
+
+static inline uint64_t _kit_atomic_add_u64(volatile uint64_t* p, uint64_t v) {
+    uint64_t prev = _kit_atomic_load_u64(p);
+    while (!_kit_atomic_cas_u64(p, &prev, prev + v)) {}
+    return prev;
+}
+
+static inline void* _kit_atomic_load_ptr(void* volatile* p) {
+    return _InterlockedCompareExchangePointer(p, NULL, NULL);
+}
+
+static inline void _kit_atomic_store_ptr(void* volatile* p, void* v) {
+    _InterlockedExchangePointer(p, v);
+}
+
+static inline bool _kit_atomic_cas_ptr(void* volatile* p, void** expected, void* desired) {
+    void* prev = _InterlockedCompareExchangePointer(p, desired, *expected);
+    if (prev == *expected) return true;
+    *expected = prev;
+    return false;
+}
+
+static inline void _kit_cpu_relax(void) {
+#if defined(_M_IX86) || defined(_M_X64)
+    _mm_pause();
+#else
+    __yield();
+#endif
+}
+#else
+#define _KIT_ATOMIC_OPS(name, type) \
+static inline type _kit_atomic_load_##name(volatile type* p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); } \
+static inline void _kit_atomic_store_##name(volatile type* p, type v) { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); } \
+static inline type _kit_atomic_add_##name(volatile type* p, type v) { return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST); } \
+static inline bool _kit_atomic_cas_##name(volatile type* p, type* expected, type desired) { \
+    return __atomic_compare_exchange_n(p, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); \
+}
+
+_KIT_ATOMIC_OPS(u32, uint32_t)
+_KIT_ATOMIC_OPS(u64, uint64_t)
+
+static inline void* _kit_atomic_load_ptr(void* volatile* p) {
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static inline void _kit_atomic_store_ptr(void* volatile* p, void* v) {
+    __atomic_store_n(p, v, __ATOMIC_SEQ_CST);
+}
+
+static inline bool _kit_atomic_cas_ptr(void* volatile* p, void** expected, void* desired) {
+    return __atomic_compare_exchange_n(p, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline void _kit_cpu_relax(void) {
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+#endif
+
+//--DEPENDENCIES----------------------------------------------------
+//m3d and the hashmap have no allocator parameter, they allocate through the calling thread's
+//dependency allocator instead. Push the caller's allocator around calls into them.
+
+kit_allocator* _kit_push_dep_allocator(kit_allocator* alloc);
+void _kit_pop_dep_allocator(kit_allocator* prev);
+void* _kit_dep_malloc(size_t size);
+void* _kit_dep_realloc(void* ptr, size_t size);
+void _kit_dep_free(void* ptr);
+
+#define M3D_MALLOC(sz)      _kit_dep_malloc(sz)
+#define M3D_REALLOC(p,nsz)  _kit_dep_realloc(p, nsz)
+#define M3D_FREE(p)         _kit_dep_free(p)
+#define HASHMAP_MALLOC(sz)  _kit_dep_malloc(sz)
+#define HASHMAP_FREE(ptr)   _kit_dep_free(ptr)
+
+//--THREADS---------------------------------------------------------
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+typedef HANDLE _kit_thread;
+#define _KIT_THREAD_PROC(name) DWORD WINAPI name(void* arg)
+typedef DWORD (WINAPI *_kit_thread_proc)(void* arg);
+
+static inline bool _kit_thread_start(_kit_thread* thread, _kit_thread_proc proc, void* arg) {
+    *thread = CreateThread(NULL, 0, proc, arg, 0, NULL);
+    return *thread != NULL;
+}
+
+static inline void _kit_thread_join(_kit_thread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+static inline void _kit_thread_yield(void) {
+    SwitchToThread();
+}
+
+static inline void _kit_sleep_ms(uint32_t ms) {
+    Sleep(ms);
+}
+
+typedef SRWLOCK _kit_mutex;
+typedef CONDITION_VARIABLE _kit_cond;
+
+static inline void _kit_mutex_init(_kit_mutex* m) { InitializeSRWLock(m); }
+static inline void _kit_mutex_destroy(_kit_mutex* m) { (void)m; }
+static inline void _kit_mutex_lock(_kit_mutex* m) { AcquireSRWLockExclusive(m); }
+static inline void _kit_mutex_unlock(_kit_mutex* m) { ReleaseSRWLockExclusive(m); }
+
+static inline void _kit_cond_init(_kit_cond* c) { InitializeConditionVariable(c); }
+static inline void _kit_cond_destroy(_kit_cond* c) { (void)c; }
+static inline void _kit_cond_wait(_kit_cond* c, _kit_mutex* m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static inline void _kit_cond_signal(_kit_cond* c) { WakeConditionVariable(c); }
+static inline void _kit_cond_broadcast(_kit_cond* c) { WakeAllConditionVariable(c); }
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+typedef pthread_t _kit_thread;
+#define _KIT_THREAD_PROC(name) void* name(void* arg)
+typedef void* (*_kit_thread_proc)(void* arg);
+
+static inline bool _kit_thread_start(_kit_thread* thread, _kit_thread_proc proc, void* arg) {
+    return pthread_create(thread, NULL, proc, arg) == 0;
+}
+
+static inline void _kit_thread_join(_kit_thread thread) {
+    pthread_join(thread, NULL);
+}
+
+static inline void _kit_thread_yield(void) {
+    sched_yield();
+}
+
+static inline void _kit_sleep_ms(uint32_t ms) {
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+typedef pthread_mutex_t _kit_mutex;
+typedef pthread_cond_t _kit_cond;
+
+static inline void _kit_mutex_init(_kit_mutex* m) { pthread_mutex_init(m, NULL); }
+static inline void _kit_mutex_destroy(_kit_mutex* m) { pthread_mutex_destroy(m); }
+static inline void _kit_mutex_lock(_kit_mutex* m) { pthread_mutex_lock(m); }
+static inline void _kit_mutex_unlock(_kit_mutex* m) { pthread_mutex_unlock(m); }
+
+static inline void _kit_cond_init(_kit_cond* c) { pthread_cond_init(c, NULL); }
+static inline void _kit_cond_destroy(_kit_cond* c) { pthread_cond_destroy(c); }
+static inline void _kit_cond_wait(_kit_cond* c, _kit_mutex* m) { pthread_cond_wait(c, m); }
+static inline void _kit_cond_signal(_kit_cond* c) { pthread_cond_signal(c); }
+static inline void _kit_cond_broadcast(_kit_cond* c) { pthread_cond_broadcast(c); }
+#endif
+
+//for short critical sections, yields once the holder seems to be descheduled
+static inline void _kit_spin_lock(volatile uint32_t* lock) {
+    uint32_t expected = 0;
+    for (int spins = 0; !_kit_atomic_cas_u32(lock, &expected, 1); spins++) {
+        expected = 0;
+        if (spins < 64) _kit_cpu_relax();
+        else _kit_thread_yield();
+    }
+}
+
+static inline void _kit_spin_unlock(volatile uint32_t* lock) {
+    _kit_atomic_store_u32(lock, 0);
+}
+
+//monotonic clock in nanoseconds, only meaningful as a difference
+static inline uint64_t _kit_now_ns(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER freq;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000ull +
+        (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000ull / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
@@ -1,12 +1,26 @@
 #include "kit.h"
+#include "kit_internal.h"
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 // from https://github.com/rxi/log.c
 
 #define MAX_CALLBACKS 32
+#define MAX_FIELDS 16
+#define JSON_BUFFER_SIZE (64 * 1024)
+#define LOG_LINE_SIZE 4096
 
 typedef struct {
     kit_log_fn fn;
@@ -14,14 +28,61 @@ typedef struct {
     kit_log_level level;
 } _kit_log_callback;
 
+typedef struct {
+    volatile uint64_t seq;
+    uint64_t order; //kit_log_event.seq
+    time_t time;
+    uint64_t time_ns;
+    const char* file;
+    int line;
+    int level;
+    uint16_t field_count;
+    uint16_t fields_offset; //packed fields follow the message in msg
+    char msg[KIT_LOG_MESSAGE_SIZE];
+} _kit_log_record;
+
+//bounded MPSC ring, a record is free for position pos when seq == pos and ready to read when seq == pos + 1
+typedef struct {
+    kit_allocator alloc;
+    _kit_log_record* records;
+    uint64_t mask;
+    kit_log_overflow overflow;
+    volatile uint64_t tail;    //next position claimed by a producer
+    uint64_t head;             //next position read by the writer
+    volatile uint64_t written; //positions the writer is done with
+    volatile uint64_t dropped; //not yet reported by the writer
+    volatile uint64_t dropped_total;
+    volatile uint32_t stop;
+    //the writer sleeps on wake when the ring is empty, producers only take the mutex while it is set
+    volatile uint32_t sleeping;
+    volatile uint32_t flush_waiters;
+    _kit_mutex mutex;
+    _kit_cond wake;
+    _kit_cond drained; //broadcast after a drain while flushes wait
+    _kit_thread thread;
+} _kit_log_ring;
+
+typedef struct _kit_log_buffers _kit_log_buffers;
+
 static struct {
     void* udata;
     kit_log_lock_fn lock;
     kit_log_level level;
     bool quiet;
+    bool batching; //set while the writer drains the ring, sinks flush once per batch
+    bool monotonic;
+    _kit_log_ring* async;
+    _kit_log_buffers* buffered;
     _kit_log_callback callbacks[MAX_CALLBACKS];
 } _kit_logger;
 
+static KIT_THREAD_LOCAL bool _kit_log_is_writer;
+
+int _kit_log_min_level = KIT_LOG_TRACE;
+
+//numbers every message, buffered lines from different threads can be put back in order by it
+static volatile uint64_t _kit_log_seq;
+
 static const char *level_strings[] = {
     "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
 };
@@ -32,34 +93,241 @@ static const char *level_colors[] = {
 };
 #endif
 
+//CLOCK
+
+typedef struct {
+    time_t second;
+    uint64_t valid_until; //monotonic ns at which the wall clock second ends
+    struct tm tm;
+    char timestamp[32];
+} _kit_log_clock;
+
+//per thread, so localtime is only called once a second by each logging thread and never shared
+static KIT_THREAD_LOCAL _kit_log_clock _log_clock;
+static volatile uint64_t _kit_log_start_ns;
+
+static uint64_t _log_start_ns(void) {
+    uint64_t start = _kit_atomic_load_u64(&_kit_log_start_ns);
+    if (!start) {
+        uint64_t now = _kit_now_ns();
+        start = _kit_atomic_cas_u64(&_kit_log_start_ns, &start, now) ? now : start;
+    }
+    return start;
+}
+
+static void _log_clock_set(_kit_log_clock* c, time_t second) {
+    c->second = second;
+#if defined(_WIN32)
+    localtime_s(&c->tm, &second);
+#else
+    localtime_r(&second, &c->tm);
+#endif
+    c->timestamp[strftime(c->timestamp, sizeof(c->timestamp), "%Y-%m-%d %H:%M:%S", &c->tm)] = '\0';
+}
+
+//reads the monotonic clock, the wall clock only when the cached second is over
+static const _kit_log_clock* _log_clock_now(uint64_t* time_ns) {
+    uint64_t start = _log_start_ns();
+    uint64_t now = _kit_now_ns();
+    _kit_log_clock* c = &_log_clock;
+    if (now >= c->valid_until) {
+        struct timespec ts;
+        timespec_get(&ts, TIME_UTC);
+        if (ts.tv_sec != c->second || !c->timestamp[0]) _log_clock_set(c, ts.tv_sec);
+        c->valid_until = now + (1000000000ull - (uint64_t)ts.tv_nsec);
+    }
+    *time_ns = now - start;
+    return c;
+}
+
+//for records logged earlier, e.g. by the async writer
+static const _kit_log_clock* _log_clock_at(time_t second) {
+    _kit_log_clock* c = &_log_clock;
+    if (c->second != second || !c->timestamp[0]) {
+        _log_clock_set(c, second);
+        c->valid_until = 0;
+    }
+    return c;
+}
+
+uint64_t kit_log_time_ns(void) {
+    uint64_t start = _log_start_ns();
+    return _kit_now_ns() - start;
+}
+
+void kit_log_set_monotonic(bool enable) {
+    _kit_logger.monotonic = enable;
+}
+
+//sinks build the whole line first so it can go to the file or into a thread buffer in one piece
+typedef struct {
+    char* buf;
+    size_t cap; //one byte is kept for the newline
+    size_t len;
+    FILE* spill; //lines that don't fit are written here directly instead of being cut
+    bool truncated;
+} _log_line;
+
+#define LOG_LINE_TRUNCATED "[...]"
+
+static void _line_vprintf(_log_line* l, const char* fmt, va_list ap) {
+    if (l->truncated) return;
+    va_list copy;
+    va_copy(copy, ap);
+    int n = vsnprintf(l->buf + l->len, l->cap - l->len, fmt, ap);
+    if (n >= 0 && l->len + (size_t)n >= l->cap) {
+        if (l->spill) {
+            fwrite(l->buf, 1, l->len, l->spill);
+            vfprintf(l->spill, fmt, copy);
+            l->len = 0;
+        } else {
+            //cut lines end in a marker, vsnprintf left the terminator after it
+            l->len = l->cap - 1;
+            size_t mark = sizeof(LOG_LINE_TRUNCATED) - 1;
+            if (l->len >= mark) memcpy(l->buf + l->len - mark, LOG_LINE_TRUNCATED, mark);
+            l->truncated = true;
+        }
+    } else if (n >= 0) {
+        l->len += (size_t)n;
+    }
+    va_end(copy);
+}
+
+static void _line_printf(_log_line* l, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    _line_vprintf(l, fmt, ap);
+    va_end(ap);
+}
+
+static void _line_prefix(_log_line* l, const kit_log_event* ev) {
+    if (_kit_logger.buffered) _line_printf(l, "#%llu ", (unsigned long long)ev->seq);
+    if (_kit_logger.monotonic) {
+        _line_printf(l, "%llu.%09llu ",
+            (unsigned long long)(ev->time_ns / 1000000000ull), (unsigned long long)(ev->time_ns % 1000000000ull));
+    }
+}
+
+static void _line_fields(_log_line* l, const kit_log_field* fields, int field_count) {
+    for (int i = 0; i < field_count; i++) {
+        const kit_log_field* field = &fields[i];
+        switch (field->type) {
+        case KIT_LOG_FIELD_INT:    _line_printf(l, " %s=%lld", field->key, (long long)field->i); break;
+        case KIT_LOG_FIELD_FLOAT:  _line_printf(l, " %s=%g", field->key, field->f); break;
+        case KIT_LOG_FIELD_BOOL:   _line_printf(l, " %s=%s", field->key, field->b ? "true" : "false"); break;
+        case KIT_LOG_FIELD_STRING: _line_printf(l, " %s=\"%s\"", field->key, field->s ? field->s : ""); break;
+        }
+    }
+}
+
+static void _buffer_write(FILE* f, kit_log_level level, uint64_t time_ns, const char* data, size_t len);
+
+static void _sink_write(const kit_log_event* ev, _log_line* l) {
+    FILE* f = ev->udata;
+    l->buf[l->len++] = '\n';
+    //the writer thread already batches, it writes through directly
+    if (_kit_logger.buffered && !_kit_logger.batching) {
+        _buffer_write(f, ev->level, ev->time_ns, l->buf, l->len);
+        return;
+    }
+    fwrite(l->buf, 1, l->len, f);
+    if (!_kit_logger.batching) fflush(f);
+}
+
+//spill long lines unless they go into a thread buffer, which takes whole lines only
+static FILE* _sink_spill(const kit_log_event* ev) {
+    return _kit_logger.buffered && !_kit_logger.batching ? NULL : ev->udata;
+}
 
 static void _stdout_callback(kit_log_event *ev) {
-    char buf[16];
-    buf[strftime(buf, sizeof(buf), "%H:%M:%S", ev->time)] = '\0';
+    char buf[LOG_LINE_SIZE];
+    _log_line l = { buf, sizeof(buf) - 1, 0, _sink_spill(ev), false };
+    //the cached timestamp without the date
+    const char* clock = ev->timestamp + 11;
+    _line_prefix(&l, ev);
     #ifdef KIT_LOG_USE_COLOR
-    fprintf(
-        ev->udata, "%s %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m ",
-        buf, level_colors[ev->level], level_strings[ev->level],
+    _line_printf(
+        &l, "%s %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m ",
+        clock, level_colors[ev->level], level_strings[ev->level],
         ev->file, ev->line);
     #else
-    fprintf(
-        ev->udata, "%s %-5s %s:%d: ",
-        buf, level_strings[ev->level], ev->file, ev->line);
+    _line_printf(
+        &l, "%s %-5s %s:%d: ",
+        clock, level_strings[ev->level], ev->file, ev->line);
     #endif
-    vfprintf(ev->udata, ev->fmt, ev->ap);
-    fprintf(ev->udata, "\n");
-    fflush(ev->udata);
+    _line_vprintf(&l, ev->fmt, ev->ap);
+    _line_fields(&l, ev->fields, ev->field_count);
+    _sink_write(ev, &l);
 }
 
 static void _file_callback(kit_log_event *ev) {
-    char buf[64];
-    buf[strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", ev->time)] = '\0';
-    fprintf(
-        ev->udata, "%s %-5s %s:%d: ",
-        buf, level_strings[ev->level], ev->file, ev->line);
-    vfprintf(ev->udata, ev->fmt, ev->ap);
-    fprintf(ev->udata, "\n");
-    fflush(ev->udata);
+    char buf[LOG_LINE_SIZE];
+    _log_line l = { buf, sizeof(buf) - 1, 0, _sink_spill(ev), false };
+    _line_prefix(&l, ev);
+    _line_printf(
+        &l, "%s %-5s %s:%d: ",
+        ev->timestamp, level_strings[ev->level], ev->file, ev->line);
+    _line_vprintf(&l, ev->fmt, ev->ap);
+    _line_fields(&l, ev->fields, ev->field_count);
+    _sink_write(ev, &l);
+}
+
+static void _json_string(FILE* f, const char* str) {
+    fputc('"', f);
+    for (const unsigned char* c = (const unsigned char*)str; *c; c++) {
+        switch (*c) {
+        case '"':  fputs("\\\"", f); break;
+        case '\\': fputs("\\\\", f); break;
+        case '\n': fputs("\\n", f); break;
+        case '\r': fputs("\\r", f); break;
+        case '\t': fputs("\\t", f); break;
+        default:
+            if (*c < 0x20) fprintf(f, "\\u%04x", *c);
+            else fputc(*c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+//no flush per line, the stream buffer is written when full, on errors and by kit_log_flush
+static void _json_callback(kit_log_event *ev) {
+    FILE* f = ev->udata;
+    char msg[KIT_LOG_MESSAGE_SIZE * 4];
+    vsnprintf(msg, sizeof(msg), ev->fmt, ev->ap);
+
+    fprintf(f, "{\"seq\":%llu,\"time\":\"%s\",\"ns\":%llu,\"level\":\"%s\",\"file\":",
+        (unsigned long long)ev->seq, ev->timestamp, (unsigned long long)ev->time_ns, level_strings[ev->level]);
+    _json_string(f, ev->file);
+    fprintf(f, ",\"line\":%d,\"msg\":", ev->line);
+    _json_string(f, msg);
+    if (ev->field_count) {
+        fputs(",\"fields\":{", f);
+        for (int i = 0; i < ev->field_count; i++) {
+            const kit_log_field* field = &ev->fields[i];
+            if (i) fputc(',', f);
+            _json_string(f, field->key);
+            fputc(':', f);
+            switch (field->type) {
+            case KIT_LOG_FIELD_INT:
+                fprintf(f, "%lld", (long long)field->i);
+                break;
+            case KIT_LOG_FIELD_FLOAT:
+                //json has no nan or infinity
+                if (field->f == field->f && field->f - field->f == 0) fprintf(f, "%.17g", field->f);
+                else fputs("null", f);
+                break;
+            case KIT_LOG_FIELD_BOOL:
+                fputs(field->b ? "true" : "false", f);
+                break;
+            case KIT_LOG_FIELD_STRING:
+                _json_string(f, field->s ? field->s : "");
+                break;
+            }
+        }
+        fputc('}', f);
+    }
+    fputs("}\n", f);
+    if (ev->level >= KIT_LOG_ERROR) fflush(f);
 }
 
 static void _lock(void)   {
@@ -83,13 +351,17 @@ void kit_log_set_lock(kit_log_lock_fn fn, void *udata) {
 }
 
 
+static void _update_min_level(void);
+
 void kit_log_set_level(kit_log_level level) {
   _kit_logger.level = level;
+  _update_min_level();
 }
 
 
 void kit_log_set_quiet(bool enable) {
   _kit_logger.quiet = enable;
+  _update_min_level();
 }
 
 
@@ -97,6 +369,7 @@ bool kit_log_add_callback(kit_log_fn fn, void *udata, kit_log_level level) {
     for (int i = 0; i < MAX_CALLBACKS; i++) {
         if (!_kit_logger.callbacks[i].fn) {
         _kit_logger.callbacks[i] = (_kit_log_callback) { fn, udata, level };
+        _update_min_level();
         return true;
         }
     }
@@ -110,28 +383,1360 @@ bool kit_log_add_file(const char *path, kit_log_level level) {
     return kit_log_add_callback(_file_callback, file, level);
 }
 
+bool kit_log_add_json(const char *path, kit_log_level level) {
+    FILE *file = fopen(path, "a");
+    if (!file) return false;
+    setvbuf(file, NULL, _IOFBF, JSON_BUFFER_SIZE);
+
+    return kit_log_add_callback(_json_callback, file, level);
+}
+
+//RING FILE
+
+#define RING_FILE_MAGIC 0x474e524bu //"KRNG"
+#define RING_FILE_VERSION 1
+#define RING_FILE_SLOT_SIZE 512
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_size;
+    uint32_t slot_count;
+    volatile uint64_t next_seq; //starts at 1, a slot with seq 0 was never written
+    uint8_t pad[40];
+} _ring_file_header;
+
+//seq is cleared before and stored after the rest, the checksum catches slots torn by a crash
+typedef struct {
+    volatile uint64_t seq;
+    uint64_t time_ns;
+    uint32_t check;
+    uint16_t len;
+    uint8_t level;
+    uint8_t pad;
+    char text[RING_FILE_SLOT_SIZE - 24]; //the line in the layout of kit_log_add_file
+} _ring_file_slot;
+
+typedef struct {
+    _ring_file_header* header;
+    _ring_file_slot* slots;
+    size_t size;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} _kit_log_ring_file;
+
+static uint32_t _ring_slot_check(const _ring_file_slot* slot, uint64_t seq) {
+    //fnv-1a over everything but seq and check, then seq
+    uint32_t h = 2166136261u;
+    const uint8_t* p = (const uint8_t*)&slot->time_ns;
+    for (size_t i = 0; i < sizeof(slot->time_ns); i++) h = (h ^ p[i]) * 16777619u;
+    p = (const uint8_t*)&slot->len;
+    for (size_t i = 0; i < offsetof(_ring_file_slot, text) - offsetof(_ring_file_slot, len) + slot->len; i++) h = (h ^ p[i]) * 16777619u;
+    for (int i = 0; i < 8; i++) h = (h ^ (uint8_t)(seq >> (i * 8))) * 16777619u;
+    return h;
+}
+
+//blocks until the pages and the file metadata are on disk
+static void _ring_file_sync(_kit_log_ring_file* ring) {
+#if defined(_WIN32)
+    FlushViewOfFile(ring->header, ring->size);
+    FlushFileBuffers(ring->file);
+#else
+    msync(ring->header, ring->size, MS_SYNC);
+#endif
+}
+
+static void _ring_file_callback(kit_log_event* ev) {
+    _kit_log_ring_file* ring = ev->udata;
+    uint64_t seq = _kit_atomic_add_u64(&ring->header->next_seq, 1);
+    _ring_file_slot* slot = &ring->slots[seq % ring->header->slot_count];
+
+    _kit_atomic_store_u64(&slot->seq, 0);
+    _log_line l = { slot->text, sizeof(slot->text), 0, NULL, false };
+    _line_printf(&l, "%s %-5s %s:%d: ", ev->timestamp, level_strings[ev->level], ev->file, ev->line);
+    _line_vprintf(&l, ev->fmt, ev->ap);
+    _line_fields(&l, ev->fields, ev->field_count);
+    slot->time_ns = ev->time_ns;
+    slot->len = (uint16_t)l.len;
+    slot->level = (uint8_t)ev->level;
+    slot->pad = 0;
+    slot->check = _ring_slot_check(slot, seq);
+    _kit_atomic_store_u64(&slot->seq, seq);
+
+    //the kernel keeps the pages of a dead process, syncing only matters if the machine goes down
+    if (ev->level == KIT_LOG_FATAL) _ring_file_sync(ring);
+}
+
+static _kit_log_ring_file* _ring_file_map(const char* path, size_t size) {
+    _kit_log_ring_file* ring = (_kit_log_ring_file*)calloc(1, sizeof(_kit_log_ring_file));
+    if (!ring) return NULL;
+    ring->size = size;
+#if defined(_WIN32)
+    ring->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (ring->file == INVALID_HANDLE_VALUE) {
+        free(ring);
+        return NULL;
+    }
+    LARGE_INTEGER current;
+    if (!GetFileSizeEx(ring->file, &current) || (uint64_t)current.QuadPart != size) {
+        LARGE_INTEGER end;
+        end.QuadPart = (LONGLONG)size;
+        SetFilePointerEx(ring->file, end, NULL, FILE_BEGIN);
+        SetEndOfFile(ring->file);
+    }
+    ring->mapping = CreateFileMappingA(ring->file, NULL, PAGE_READWRITE, 0, 0, NULL);
+    ring->header = ring->mapping ? (_ring_file_header*)MapViewOfFile(ring->mapping, FILE_MAP_WRITE, 0, 0, size) : NULL;
+    if (!ring->header) {
+        if (ring->mapping) CloseHandle(ring->mapping);
+        CloseHandle(ring->file);
+        free(ring);
+        return NULL;
+    }
+#else
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        free(ring);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != size) {
+        if (ftruncate(fd, (off_t)size) != 0) {
+            close(fd);
+            free(ring);
+            return NULL;
+        }
+    }
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    //the mapping keeps the file alive
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        free(ring);
+        return NULL;
+    }
+    ring->header = (_ring_file_header*)ptr;
+#endif
+    ring->slots = (_ring_file_slot*)(ring->header + 1);
+    return ring;
+}
+
+bool kit_log_add_ring_file(const char* path, uint32_t slot_count, kit_log_level level) {
+    slot_count = KIT_DEF(slot_count, 4096);
+    size_t size = sizeof(_ring_file_header) + (size_t)slot_count * sizeof(_ring_file_slot);
+    _kit_log_ring_file* ring = _ring_file_map(path, size);
+    if (!ring) {
+        kit_log_error("Failed to map log ring file: %s", path);
+        return false;
+    }
+
+    //a ring left by an earlier run is continued, its tail stays readable until overwritten
+    _ring_file_header* header = ring->header;
+    if (header->magic != RING_FILE_MAGIC || header->version != RING_FILE_VERSION ||
+        header->slot_size != sizeof(_ring_file_slot) || header->slot_count != slot_count) {
+        memset(header, 0, size);
+        header->magic = RING_FILE_MAGIC;
+        header->version = RING_FILE_VERSION;
+        header->slot_size = sizeof(_ring_file_slot);
+        header->slot_count = slot_count;
+        header->next_seq = 1;
+    }
+
+    //the mapping lives as long as the process, like the files of kit_log_add_file
+    return kit_log_add_callback(_ring_file_callback, ring, level);
+}
+
+static int _ring_cmp_slot(const void* a, const void* b) {
+    uint64_t x = (*(const _ring_file_slot* const*)a)->seq;
+    uint64_t y = (*(const _ring_file_slot* const*)b)->seq;
+    return x < y ? -1 : x > y;
+}
+
+bool kit_log_render_ring_file(kit_allocator* alloc, const char* path, FILE* out) {
+    if (!alloc || !path || !out) return false;
+
+    kit_file_error err = KIT_FILE_ERROR_NONE;
+    kit_memory mem = kit_read_file(alloc, path, false, &err);
+    if (!mem.ptr) return false;
+
+    _ring_file_header header;
+    if (mem.size < sizeof(header) || (memcpy(&header, mem.ptr, sizeof(header)), header.magic != RING_FILE_MAGIC) ||
+        header.version != RING_FILE_VERSION || header.slot_size != sizeof(_ring_file_slot) ||
+        mem.size < sizeof(header) + (size_t)header.slot_count * sizeof(_ring_file_slot)) {
+        kit_log_error("Not a log ring file: %s", path);
+        kit_free_sized(alloc, mem.ptr, mem.size + 1);
+        return false;
+    }
+
+    //kit_read_file's buffer is aligned for the slots
+    _ring_file_slot* slots = (_ring_file_slot*)(mem.ptr + sizeof(header));
+    _ring_file_slot** order = (_ring_file_slot**)kit_alloc(alloc, ((size_t)header.slot_count + 1) * sizeof(_ring_file_slot*));
+    if (!order) {
+        kit_free_sized(alloc, mem.ptr, mem.size + 1);
+        return false;
+    }
+    size_t count = 0, torn = 0;
+    for (uint32_t i = 0; i < header.slot_count; i++) {
+        _ring_file_slot* slot = &slots[i];
+        if (!slot->seq) continue;
+        if (slot->len >= sizeof(slot->text) || slot->level > KIT_LOG_FATAL ||
+            slot->seq % header.slot_count != i || _ring_slot_check(slot, slot->seq) != slot->check) {
+            torn++;
+            continue;
+        }
+        order[count++] = slot;
+    }
+    qsort(order, count, sizeof(_ring_file_slot*), _ring_cmp_slot);
+
+    for (size_t i = 0; i < count; i++) {
+        _ring_file_slot* slot = order[i];
+        if (i && slot->seq != order[i - 1]->seq + 1) {
+            fprintf(out, "-- %llu messages missing\n", (unsigned long long)(slot->seq - order[i - 1]->seq - 1));
+        }
+        fprintf(out, "%.*s\n", (int)slot->len, slot->text);
+    }
+    if (torn) fprintf(out, "-- %zu torn slots skipped\n", torn);
+
+    kit_free_sized(alloc, order, ((size_t)header.slot_count + 1) * sizeof(_ring_file_slot*));
+    kit_free_sized(alloc, mem.ptr, mem.size + 1);
+    return true;
+}
+
 static void _init_event(kit_log_event* ev, void *udata) {
-    if (!ev->time) {
-        time_t t = time(NULL);
-        ev->time = localtime(&t);
+    ev->udata = udata;
+}
+
+
+//BINARY
+
+#define BINLOG_MAGIC 0x474f4c42u //"BLOG"
+#define BINLOG_VERSION 1
+#define BINLOG_STRING_CACHE 256
+#define BINLOG_MAX_ARGS 1024
+
+enum {
+    BINLOG_RECORD = 1,
+    BINLOG_STRING = 2,
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t start_time; //wall clock seconds at start_ns
+    uint64_t start_ns;
+} _binlog_file_header;
+
+typedef struct {
+    uint32_t size;
+    uint32_t thread;
+} _binlog_chunk_header;
+
+//records are packed, fields are copied in and out with memcpy
+typedef struct {
+    uint8_t type;
+    uint8_t level;
+    uint16_t args_size;
+    uint32_t line;
+    uint64_t time_ns;
+    uint64_t fmt;
+    uint64_t file;
+} _binlog_record;
+
+typedef struct {
+    uint8_t type;
+    uint8_t pad[3];
+    uint32_t size; //including the terminator
+    uint64_t id;
+} _binlog_string;
+
+typedef struct _binlog_thread {
+    struct _binlog_thread* next;
+    volatile uint32_t lock; //taken by the owner per message and by flushes from other threads
+    uint32_t index;
+    size_t used;
+    uint8_t* buffer;
+    const void* strings[BINLOG_STRING_CACHE];
+} _binlog_thread;
+
+typedef struct {
+    kit_allocator alloc;
+    FILE* file;
+    size_t buffer_size;
+    kit_log_level level;
+    uint32_t generation;
+    volatile uint32_t lock; //file writes and the thread list
+    _binlog_thread* threads;
+    uint32_t thread_count;
+} _kit_binlog;
+
+static _kit_binlog* _kit_binlog_state;
+static uint32_t _kit_binlog_generation;
+static KIT_THREAD_LOCAL _binlog_thread* _binlog_local;
+static KIT_THREAD_LOCAL uint32_t _binlog_local_generation;
+
+enum {
+    FMT_LEN_NONE,
+    FMT_LEN_HH,
+    FMT_LEN_H,
+    FMT_LEN_L,
+    FMT_LEN_LL,
+    FMT_LEN_Z,
+    FMT_LEN_J,
+    FMT_LEN_T,
+    FMT_LEN_LD,
+};
+
+typedef struct {
+    const char* start; //the '%'
+    const char* end;   //one past the conversion
+    const char* length_start;
+    int length;
+    int precision;     //-1 without a literal precision
+    char conv;
+    bool star_width;
+    bool star_precision;
+} _fmt_spec;
+
+//finds the next conversion, returns false at the end of the string
+static bool _fmt_next(const char** p, _fmt_spec* spec) {
+    const char* s = strchr(*p, '%');
+    if (!s) return false;
+    *spec = (_fmt_spec){ .start = s, .precision = -1 };
+    s++;
+    while (*s && strchr("-+ #0'", *s)) s++;
+    if (*s == '*') { spec->star_width = true; s++; }
+    while (*s >= '0' && *s <= '9') s++;
+    if (*s == '.') {
+        s++;
+        if (*s == '*') { spec->star_precision = true; s++; }
+        else spec->precision = 0;
+        while (*s >= '0' && *s <= '9') spec->precision = spec->precision * 10 + (*s++ - '0');
+    }
+    spec->length_start = s;
+    switch (*s) {
+    case 'h': spec->length = s[1] == 'h' ? FMT_LEN_HH : FMT_LEN_H; s += s[1] == 'h' ? 2 : 1; break;
+    case 'l': spec->length = s[1] == 'l' ? FMT_LEN_LL : FMT_LEN_L; s += s[1] == 'l' ? 2 : 1; break;
+    case 'z': spec->length = FMT_LEN_Z; s++; break;
+    case 'j': spec->length = FMT_LEN_J; s++; break;
+    case 't': spec->length = FMT_LEN_T; s++; break;
+    case 'L': spec->length = FMT_LEN_LD; s++; break;
+    }
+    spec->conv = *s;
+    spec->end = *s ? s + 1 : s;
+    *p = spec->end;
+    return true;
+}
+
+static bool _put(uint8_t* out, size_t* size, size_t cap, const void* data, size_t len) {
+    if (*size + len > cap) return false;
+    memcpy(out + *size, data, len);
+    *size += len;
+    return true;
+}
+
+#define BINLOG_NOT_ENCODABLE ((size_t)-1)
+
+//integers are widened to 64 bit after truncating to their type, floats stored as double.
+//wide characters and strings can't be encoded, the caller formats those messages as text.
+static size_t _binlog_encode_args(const char* fmt, va_list ap, uint8_t* out, size_t cap) {
+    size_t size = 0;
+    _fmt_spec spec;
+    while (_fmt_next(&fmt, &spec)) {
+        if ((spec.conv == 's' || spec.conv == 'c') && spec.length == FMT_LEN_L) return BINLOG_NOT_ENCODABLE;
+        int precision = spec.precision;
+        if (spec.star_width) {
+            int64_t v = va_arg(ap, int);
+            if (!_put(out, &size, cap, &v, sizeof(v))) return size;
+        }
+        if (spec.star_precision) {
+            int64_t v = va_arg(ap, int);
+            precision = v < 0 ? -1 : (int)v;
+            if (!_put(out, &size, cap, &v, sizeof(v))) return size;
+        }
+        int64_t i = 0;
+        double d = 0;
+        switch (spec.conv) {
+        case 'd': case 'i':
+            switch (spec.length) {
+            case FMT_LEN_HH: i = (signed char)va_arg(ap, int); break;
+            case FMT_LEN_H:  i = (short)va_arg(ap, int); break;
+            case FMT_LEN_L:  i = va_arg(ap, long); break;
+            case FMT_LEN_LL: i = va_arg(ap, long long); break;
+            case FMT_LEN_Z:  i = (int64_t)va_arg(ap, size_t); break;
+            case FMT_LEN_J:  i = va_arg(ap, intmax_t); break;
+            case FMT_LEN_T:  i = va_arg(ap, ptrdiff_t); break;
+            default:         i = va_arg(ap, int); break;
+            }
+            if (!_put(out, &size, cap, &i, sizeof(i))) return size;
+            break;
+        case 'u': case 'o': case 'x': case 'X':
+            switch (spec.length) {
+            case FMT_LEN_HH: i = (unsigned char)va_arg(ap, unsigned); break;
+            case FMT_LEN_H:  i = (unsigned short)va_arg(ap, unsigned); break;
+            case FMT_LEN_L:  i = (int64_t)va_arg(ap, unsigned long); break;
+            case FMT_LEN_LL: i = (int64_t)va_arg(ap, unsigned long long); break;
+            case FMT_LEN_Z:  i = (int64_t)va_arg(ap, size_t); break;
+            case FMT_LEN_J:  i = (int64_t)va_arg(ap, uintmax_t); break;
+            case FMT_LEN_T:  i = (int64_t)va_arg(ap, ptrdiff_t); break;
+            default:         i = va_arg(ap, unsigned); break;
+            }
+            if (!_put(out, &size, cap, &i, sizeof(i))) return size;
+            break;
+        case 'c':
+            i = va_arg(ap, int);
+            if (!_put(out, &size, cap, &i, sizeof(i))) return size;
+            break;
+        case 'p':
+            i = (int64_t)(uintptr_t)va_arg(ap, void*);
+            if (!_put(out, &size, cap, &i, sizeof(i))) return size;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            d = spec.length == FMT_LEN_LD ? (double)va_arg(ap, long double) : va_arg(ap, double);
+            if (!_put(out, &size, cap, &d, sizeof(d))) return size;
+            break;
+        case 's': {
+            const char* str = va_arg(ap, const char*);
+            if (!str) str = "(null)";
+            //a precision bounds the read, the string may not be terminated
+            size_t len = precision < 0 ? strlen(str) : strnlen(str, (size_t)precision);
+            if (size + sizeof(uint32_t) > cap) return size;
+            if (len > cap - size - sizeof(uint32_t)) len = cap - size - sizeof(uint32_t);
+            uint32_t len32 = (uint32_t)len;
+            _put(out, &size, cap, &len32, sizeof(len32));
+            _put(out, &size, cap, str, len);
+        } break;
+        case 'n':
+            (void)va_arg(ap, int*);
+            break;
+        case '%':
+            break;
+        default:
+            //unknown conversion, the remaining arguments can't be read
+            return size;
+        }
+    }
+    return size;
+}
+
+static void _binlog_write_chunk(_kit_binlog* log, _binlog_thread* t) {
+    if (!t->used) return;
+    _binlog_chunk_header chunk = { (uint32_t)t->used, t->index };
+    _kit_spin_lock(&log->lock);
+    fwrite(&chunk, sizeof(chunk), 1, log->file);
+    fwrite(t->buffer, 1, t->used, log->file);
+    _kit_spin_unlock(&log->lock);
+    t->used = 0;
+}
+
+static uint8_t* _binlog_reserve(_kit_binlog* log, _binlog_thread* t, size_t size) {
+    if (t->used + size > log->buffer_size) _binlog_write_chunk(log, t);
+    uint8_t* ret = t->buffer + t->used;
+    t->used += size;
+    return ret;
+}
+
+//writes the string once per thread, the reader collects them from every chunk
+static void _binlog_register(_kit_binlog* log, _binlog_thread* t, const char* str) {
+    size_t hash = ((size_t)str >> 3) * 0x9e3779b97f4a7c15ull;
+    for (int probe = 0; probe < 8; probe++) {
+        const void** slot = &t->strings[(hash + probe) % BINLOG_STRING_CACHE];
+        if (*slot == str) return;
+        if (!*slot) {
+            *slot = str;
+            break;
+        }
+    }
+
+    size_t len = strlen(str);
+    if (len >= BINLOG_MAX_ARGS) len = BINLOG_MAX_ARGS - 1;
+    _binlog_string def = { .type = BINLOG_STRING, .size = (uint32_t)len + 1, .id = (uint64_t)(uintptr_t)str };
+    uint8_t* p = _binlog_reserve(log, t, sizeof(def) + len + 1);
+    memcpy(p, &def, sizeof(def));
+    memcpy(p + sizeof(def), str, len);
+    p[sizeof(def) + len] = '\0';
+}
+
+static _binlog_thread* _binlog_thread_get(_kit_binlog* log) {
+    if (_binlog_local && _binlog_local_generation == log->generation) return _binlog_local;
+
+    _kit_spin_lock(&log->lock);
+    _binlog_thread* t = (_binlog_thread*)kit_alloc(&log->alloc, sizeof(_binlog_thread));
+    uint8_t* buffer = t ? (uint8_t*)kit_alloc(&log->alloc, log->buffer_size) : NULL;
+    if (t && buffer) {
+        memset(t, 0, sizeof(_binlog_thread));
+        t->buffer = buffer;
+        t->index = log->thread_count++;
+        t->next = log->threads;
+        log->threads = t;
+    } else if (t) {
+        kit_free(&log->alloc, t);
+        t = NULL;
+    }
+    _kit_spin_unlock(&log->lock);
+
+    _binlog_local = t;
+    _binlog_local_generation = log->generation;
+    return t;
+}
+
+static void _binlog_flush(_kit_binlog* log) {
+    _kit_spin_lock(&log->lock);
+    _binlog_thread* threads = log->threads;
+    _kit_spin_unlock(&log->lock);
+
+    //threads are only ever pushed to the front, the snapshot stays valid
+    for (_binlog_thread* t = threads; t; t = t->next) {
+        _kit_spin_lock(&t->lock);
+        _binlog_write_chunk(log, t);
+        _kit_spin_unlock(&t->lock);
+    }
+    _kit_spin_lock(&log->lock);
+    fflush(log->file);
+    _kit_spin_unlock(&log->lock);
+}
+
+//false if the arguments have to be formatted as text first
+static bool _log_binary(_kit_binlog* log, kit_log_level level, const char* file, int line, const char* fmt, va_list ap) {
+    uint8_t args[BINLOG_MAX_ARGS];
+    _binlog_record rec = {
+        .type = BINLOG_RECORD,
+        .level = (uint8_t)level,
+        .line = (uint32_t)line,
+        .time_ns = _kit_now_ns(),
+        .fmt = (uint64_t)(uintptr_t)fmt,
+        .file = (uint64_t)(uintptr_t)file,
+    };
+    size_t args_size = _binlog_encode_args(fmt, ap, args, sizeof(args));
+    if (args_size == BINLOG_NOT_ENCODABLE) return false;
+    rec.args_size = (uint16_t)args_size;
+
+    _binlog_thread* t = _binlog_thread_get(log);
+    if (!t) return true;
+    _kit_spin_lock(&t->lock);
+    _binlog_register(log, t, fmt);
+    _binlog_register(log, t, file);
+    uint8_t* p = _binlog_reserve(log, t, sizeof(rec) + rec.args_size);
+    memcpy(p, &rec, sizeof(rec));
+    memcpy(p + sizeof(rec), args, rec.args_size);
+    _kit_spin_unlock(&t->lock);
+    //every thread's records reach the file before the crash that follows
+    if (level == KIT_LOG_FATAL) _binlog_flush(log);
+    return true;
+}
+
+bool kit_log_start_binary(kit_allocator* alloc, const kit_log_binary_desc* desc) {
+    if (!alloc || !desc || !desc->path || _kit_binlog_state) return false;
+
+    size_t buffer_size = KIT_DEF(desc->buffer_size, 64 * 1024);
+    if (buffer_size < 4 * BINLOG_MAX_ARGS) buffer_size = 4 * BINLOG_MAX_ARGS;
+
+    FILE* file = fopen(desc->path, "wb");
+    if (!file) {
+        kit_log_error("Failed to open binary log file: %s", desc->path);
+        return false;
+    }
+    _kit_binlog* log = (_kit_binlog*)kit_alloc(alloc, sizeof(_kit_binlog));
+    if (!log) {
+        fclose(file);
+        return false;
+    }
+    *log = (_kit_binlog){
+        .alloc = *alloc,
+        .file = file,
+        .buffer_size = buffer_size,
+        .level = desc->level,
+        .generation = ++_kit_binlog_generation,
+    };
+
+    _binlog_file_header header = {
+        .magic = BINLOG_MAGIC,
+        .version = BINLOG_VERSION,
+        .start_time = (int64_t)time(NULL),
+        .start_ns = _kit_now_ns(),
+    };
+    fwrite(&header, sizeof(header), 1, file);
+    _kit_binlog_state = log;
+    _update_min_level();
+    return true;
+}
+
+void kit_log_stop_binary(void) {
+    _kit_binlog* log = _kit_binlog_state;
+    if (!log) return;
+    _kit_binlog_state = NULL;
+    _update_min_level();
+    _binlog_flush(log);
+    fclose(log->file);
+
+    _binlog_thread* t = log->threads;
+    while (t) {
+        _binlog_thread* next = t->next;
+        kit_free(&log->alloc, t->buffer);
+        kit_free(&log->alloc, t);
+        t = next;
+    }
+    kit_allocator alloc = log->alloc;
+    kit_free(&alloc, log);
+}
+
+typedef struct {
+    uint64_t id;
+    const char* str;
+} _binlog_string_entry;
+
+typedef struct {
+    const uint8_t* rec;
+    uint64_t time_ns;
+    size_t order;
+} _binlog_record_entry;
+
+static int _binlog_cmp_string(const void* a, const void* b) {
+    uint64_t x = ((const _binlog_string_entry*)a)->id, y = ((const _binlog_string_entry*)b)->id;
+    return (x > y) - (x < y);
+}
+
+static int _binlog_cmp_record(const void* a, const void* b) {
+    const _binlog_record_entry* x = (const _binlog_record_entry*)a;
+    const _binlog_record_entry* y = (const _binlog_record_entry*)b;
+    if (x->time_ns != y->time_ns) return (x->time_ns > y->time_ns) - (x->time_ns < y->time_ns);
+    return (x->order > y->order) - (x->order < y->order);
+}
+
+static const char* _binlog_lookup(_binlog_string_entry* strings, size_t count, uint64_t id) {
+    _binlog_string_entry key = { id, NULL };
+    _binlog_string_entry* e = (_binlog_string_entry*)bsearch(&key, strings, count, sizeof(key), _binlog_cmp_string);
+    return e ? e->str : "?";
+}
+
+static bool _get(const uint8_t* args, size_t* pos, size_t size, void* out, size_t len) {
+    if (*pos + len > size) return false;
+    memcpy(out, args + *pos, len);
+    *pos += len;
+    return true;
+}
+
+static void _binlog_render_args(FILE* out, const char* fmt, const uint8_t* args, size_t size) {
+    size_t pos = 0;
+    _fmt_spec spec;
+    const char* p = fmt;
+    while (_fmt_next(&p, &spec)) {
+        fwrite(fmt, 1, (size_t)(spec.start - fmt), out);
+        fmt = spec.end;
+
+        //the spec without its length modifier, integers are printed as 64 bit
+        char conv[64];
+        size_t head = (size_t)(spec.length_start - spec.start);
+        if (head + 4 > sizeof(conv) || !spec.conv) {
+            fwrite(spec.start, 1, (size_t)(spec.end - spec.start), out);
+            continue;
+        }
+        memcpy(conv, spec.start, head);
+        bool integer = strchr("diuoxX", spec.conv) != NULL;
+        if (integer) {
+            conv[head++] = 'l';
+            conv[head++] = 'l';
+        }
+        conv[head++] = spec.conv;
+        conv[head] = '\0';
+
+        int64_t star[2] = {0};
+        int stars = 0;
+        if (spec.star_width && !_get(args, &pos, size, &star[stars++], sizeof(int64_t))) return;
+        if (spec.star_precision && !_get(args, &pos, size, &star[stars++], sizeof(int64_t))) return;
+
+        int64_t i = 0;
+        double d = 0;
+        char* str = NULL;
+        switch (spec.conv) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c': case 'p':
+            if (!_get(args, &pos, size, &i, sizeof(i))) return;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (!_get(args, &pos, size, &d, sizeof(d))) return;
+            break;
+        case 's': {
+            uint32_t len = 0;
+            if (!_get(args, &pos, size, &len, sizeof(len)) || pos + len > size) return;
+            str = (char*)malloc(len + 1);
+            if (!str) return;
+            memcpy(str, args + pos, len);
+            str[len] = '\0';
+            pos += len;
+        } break;
+        case '%':
+            fputc('%', out);
+            continue;
+        case 'n':
+            continue;
+        default:
+            fputs(spec.start, out);
+            return;
+        }
+
+#define _PRINT(...) \
+        (stars == 0 ? fprintf(out, conv, __VA_ARGS__) : \
+         stars == 1 ? fprintf(out, conv, (int)star[0], __VA_ARGS__) : \
+                      fprintf(out, conv, (int)star[0], (int)star[1], __VA_ARGS__))
+        if (str) _PRINT(str);
+        else if (spec.conv == 'p') _PRINT((void*)(uintptr_t)i);
+        else if (spec.conv == 'c') _PRINT((int)i);
+        else if (integer) _PRINT((long long)i);
+        else _PRINT(d);
+#undef _PRINT
+        free(str);
+    }
+    fputs(fmt, out);
+}
+
+bool kit_log_render_binary(kit_allocator* alloc, const char* path, FILE* out) {
+    if (!alloc || !path || !out) return false;
+
+    kit_file_error err = KIT_FILE_ERROR_NONE;
+    kit_memory mem = kit_read_file(alloc, path, false, &err);
+    if (!mem.ptr) return false;
+
+    _binlog_file_header header;
+    if (mem.size < sizeof(header) || (memcpy(&header, mem.ptr, sizeof(header)), header.magic != BINLOG_MAGIC) ||
+        header.version != BINLOG_VERSION) {
+        kit_log_error("Not a binary log: %s", path);
+        kit_free_sized(alloc, mem.ptr, mem.size + 1);
+        return false;
+    }
+
+    //first pass counts, second pass fills the tables
+    _binlog_string_entry* strings = NULL;
+    _binlog_record_entry* records = NULL;
+    size_t string_count = 0, record_count = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            strings = (_binlog_string_entry*)kit_alloc(alloc, (string_count + 1) * sizeof(_binlog_string_entry));
+            records = (_binlog_record_entry*)kit_alloc(alloc, (record_count + 1) * sizeof(_binlog_record_entry));
+            if (!strings || !records) break;
+            string_count = record_count = 0;
+        }
+        size_t pos = sizeof(header);
+        while (pos + sizeof(_binlog_chunk_header) <= mem.size) {
+            _binlog_chunk_header chunk;
+            memcpy(&chunk, mem.ptr + pos, sizeof(chunk));
+            pos += sizeof(chunk);
+            size_t end = pos + chunk.size;
+            if (end > mem.size) break; //cut off by a crash
+            while (pos < end) {
+                if (mem.ptr[pos] == BINLOG_STRING && pos + sizeof(_binlog_string) <= end) {
+                    _binlog_string def;
+                    memcpy(&def, mem.ptr + pos, sizeof(def));
+                    if (pass == 1) strings[string_count] = (_binlog_string_entry){ def.id, (const char*)mem.ptr + pos + sizeof(def) };
+                    string_count++;
+                    pos += sizeof(def) + def.size;
+                } else if (mem.ptr[pos] == BINLOG_RECORD && pos + sizeof(_binlog_record) <= end) {
+                    _binlog_record rec;
+                    memcpy(&rec, mem.ptr + pos, sizeof(rec));
+                    if (pass == 1) records[record_count] = (_binlog_record_entry){ mem.ptr + pos, rec.time_ns, record_count };
+                    record_count++;
+                    pos += sizeof(rec) + rec.args_size;
+                } else {
+                    pos = end;
+                }
+            }
+            pos = end;
+        }
+    }
+
+    bool ok = strings && records;
+    if (ok) {
+        qsort(strings, string_count, sizeof(_binlog_string_entry), _binlog_cmp_string);
+        qsort(records, record_count, sizeof(_binlog_record_entry), _binlog_cmp_record);
+        for (size_t i = 0; i < record_count; i++) {
+            _binlog_record rec;
+            memcpy(&rec, records[i].rec, sizeof(rec));
+            uint64_t since = rec.time_ns - header.start_ns;
+            time_t t = (time_t)(header.start_time + (int64_t)(since / 1000000000ull));
+            char buf[64];
+            buf[strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&t))] = '\0';
+            fprintf(out, "%s.%06u %-5s %s:%u: ", buf, (unsigned)(since % 1000000000ull / 1000),
+                level_strings[rec.level <= KIT_LOG_FATAL ? rec.level : KIT_LOG_FATAL],
+                _binlog_lookup(strings, string_count, rec.file), rec.line);
+            _binlog_render_args(out, _binlog_lookup(strings, string_count, rec.fmt),
+                records[i].rec + sizeof(rec), rec.args_size);
+            fputc('\n', out);
+        }
+    }
+
+    if (strings) kit_free(alloc, strings);
+    if (records) kit_free(alloc, records);
+    kit_free_sized(alloc, mem.ptr, mem.size + 1);
+    return ok;
+}
+
+//BUFFERED
+
+typedef struct _log_thread_buffer {
+    struct _log_thread_buffer* next;
+    volatile uint32_t lock; //taken by the owning thread and the flusher
+    uint64_t first_ns;      //time of the oldest line in data
+    size_t used;
+    char* data;             //entries of _log_buffer_entry and the line
+    char* scratch;          //lines of one file gathered for a single write
+} _log_thread_buffer;
+
+typedef struct {
+    FILE* file;
+    uint32_t size;
+} _log_buffer_entry;
+
+struct _kit_log_buffers {
+    kit_allocator alloc;
+    size_t size;
+    uint64_t interval_ns;
+    kit_log_level flush_level;
+    volatile uint32_t lock; //guards the thread list
+    _log_thread_buffer* threads;
+    uint32_t generation;
+    volatile uint32_t stop;
+    _kit_thread thread;
+};
+
+static uint32_t _kit_log_buffers_generation;
+static KIT_THREAD_LOCAL _log_thread_buffer* _buffer_local;
+static KIT_THREAD_LOCAL uint32_t _buffer_local_generation;
+
+//one write per file, lines keep their order within the file
+static void _buffer_flush(_log_thread_buffer* t) {
+    FILE* done[MAX_CALLBACKS + 1];
+    int done_count = 0;
+    for (size_t pos = 0; pos < t->used;) {
+        _log_buffer_entry e;
+        memcpy(&e, t->data + pos, sizeof(e));
+        bool seen = false;
+        for (int i = 0; i < done_count && !seen; i++) seen = done[i] == e.file;
+        if (!seen) {
+            size_t len = 0;
+            for (size_t p = pos; p < t->used;) {
+                _log_buffer_entry other;
+                memcpy(&other, t->data + p, sizeof(other));
+                if (other.file == e.file) {
+                    memcpy(t->scratch + len, t->data + p + sizeof(other), other.size);
+                    len += other.size;
+                }
+                p += sizeof(other) + other.size;
+            }
+            fwrite(t->scratch, 1, len, e.file);
+            fflush(e.file);
+            if (done_count < MAX_CALLBACKS + 1) done[done_count++] = e.file;
+        }
+        pos += sizeof(e) + e.size;
+    }
+    t->used = 0;
+}
+
+static void _buffer_flush_all(_kit_log_buffers* b, uint64_t older_than_ns) {
+    _kit_spin_lock(&b->lock);
+    _log_thread_buffer* threads = b->threads;
+    _kit_spin_unlock(&b->lock);
+
+    uint64_t now = kit_log_time_ns();
+    //threads are only ever pushed to the front, the snapshot stays valid
+    for (_log_thread_buffer* t = threads; t; t = t->next) {
+        _kit_spin_lock(&t->lock);
+        if (t->used && now - t->first_ns >= older_than_ns) _buffer_flush(t);
+        _kit_spin_unlock(&t->lock);
     }
+}
+
+static _log_thread_buffer* _buffer_thread_get(_kit_log_buffers* b) {
+    if (_buffer_local && _buffer_local_generation == b->generation) return _buffer_local;
+
+    _kit_spin_lock(&b->lock);
+    _log_thread_buffer* t = (_log_thread_buffer*)kit_alloc(&b->alloc, sizeof(_log_thread_buffer));
+    char* data = t ? (char*)kit_alloc(&b->alloc, 2 * b->size) : NULL;
+    if (t && data) {
+        memset(t, 0, sizeof(_log_thread_buffer));
+        t->data = data;
+        t->scratch = data + b->size;
+        t->next = b->threads;
+        b->threads = t;
+    } else if (t) {
+        kit_free(&b->alloc, t);
+        t = NULL;
+    }
+    _kit_spin_unlock(&b->lock);
+
+    _buffer_local = t;
+    _buffer_local_generation = b->generation;
+    return t;
+}
+
+static void _buffer_write(FILE* f, kit_log_level level, uint64_t time_ns, const char* data, size_t len) {
+    _kit_log_buffers* b = _kit_logger.buffered;
+    _log_thread_buffer* t = _buffer_thread_get(b);
+    if (!t) {
+        fwrite(data, 1, len, f);
+        fflush(f);
+        return;
+    }
+
+    _log_buffer_entry e = { f, (uint32_t)len };
+    _kit_spin_lock(&t->lock);
+    if (t->used + sizeof(e) + len > b->size) _buffer_flush(t);
+    if (!t->used) t->first_ns = time_ns;
+    memcpy(t->data + t->used, &e, sizeof(e));
+    memcpy(t->data + t->used + sizeof(e), data, len);
+    t->used += sizeof(e) + len;
+    if (level >= b->flush_level || time_ns - t->first_ns >= b->interval_ns) _buffer_flush(t);
+    _kit_spin_unlock(&t->lock);
+}
+
+//writes out buffers of threads that stopped logging
+static _KIT_THREAD_PROC(_log_flusher) {
+    _kit_log_buffers* b = (_kit_log_buffers*)arg;
+    uint32_t sleep_ms = (uint32_t)(b->interval_ns / 2000000ull);
+    if (sleep_ms == 0) sleep_ms = 1;
+    while (!_kit_atomic_load_u32(&b->stop)) {
+        _kit_sleep_ms(sleep_ms);
+        _buffer_flush_all(b, b->interval_ns);
+    }
+    return 0;
+}
+
+bool kit_log_start_buffered(kit_allocator* alloc, const kit_log_buffer_desc* desc) {
+    if (!alloc || !desc || _kit_logger.buffered) return false;
+
+    size_t size = KIT_DEF(desc->size, 16 * 1024);
+    if (size < 2 * LOG_LINE_SIZE) size = 2 * LOG_LINE_SIZE;
+
+    _kit_log_buffers* b = (_kit_log_buffers*)kit_alloc(alloc, sizeof(_kit_log_buffers));
+    if (!b) return false;
+    *b = (_kit_log_buffers){
+        .alloc = *alloc,
+        .size = size,
+        .interval_ns = (uint64_t)KIT_DEF(desc->interval_ms, 100) * 1000000ull,
+        .flush_level = KIT_DEF(desc->flush_level, KIT_LOG_ERROR),
+        .generation = ++_kit_log_buffers_generation,
+    };
+    if (!_kit_thread_start(&b->thread, _log_flusher, b)) {
+        kit_free(alloc, b);
+        kit_log_error("Failed to start the log flusher thread!");
+        return false;
+    }
+    _kit_logger.buffered = b;
+    return true;
+}
+
+void kit_log_stop_buffered(void) {
+    _kit_log_buffers* b = _kit_logger.buffered;
+    if (!b) return;
+    _kit_atomic_store_u32(&b->stop, 1);
+    _kit_thread_join(b->thread);
+    _kit_logger.buffered = NULL;
+    _buffer_flush_all(b, 0);
+
+    _log_thread_buffer* t = b->threads;
+    while (t) {
+        _log_thread_buffer* next = t->next;
+        kit_free(&b->alloc, t->data);
+        kit_free(&b->alloc, t);
+        t = next;
+    }
+    kit_allocator alloc = b->alloc;
+    kit_free(&alloc, b);
+}
+
+static void _update_min_level(void) {
+    int level = KIT_LOG_FATAL + 1;
+    if (!_kit_logger.quiet) level = _kit_logger.level;
+    for (int i = 0; i < MAX_CALLBACKS && _kit_logger.callbacks[i].fn; i++) {
+        if ((int)_kit_logger.callbacks[i].level < level) level = _kit_logger.callbacks[i].level;
+    }
+    if (_kit_binlog_state && (int)_kit_binlog_state->level < level) level = _kit_binlog_state->level;
+    _kit_log_min_level = level;
+}
+
+//ASYNC
+
+static bool _log_wanted(kit_log_level level) {
+    if (!_kit_logger.quiet && level >= _kit_logger.level) return true;
+    for (int i = 0; i < MAX_CALLBACKS && _kit_logger.callbacks[i].fn; i++) {
+        if (level >= _kit_logger.callbacks[i].level) return true;
+    }
+    return false;
+}
+
+static _kit_log_record* _ring_claim(_kit_log_ring* ring, uint64_t* pos_out) {
+    uint64_t pos = _kit_atomic_load_u64(&ring->tail);
+    for (;;) {
+        _kit_log_record* rec = &ring->records[pos & ring->mask];
+        int64_t diff = (int64_t)(_kit_atomic_load_u64(&rec->seq) - pos);
+        if (diff == 0) {
+            if (_kit_atomic_cas_u64(&ring->tail, &pos, pos + 1)) {
+                *pos_out = pos;
+                return rec;
+            }
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            pos = _kit_atomic_load_u64(&ring->tail);
+        }
+    }
+}
+
+//callbacks expect a va_list, the writer hands them the finished message through "%s"
+static void _dispatch(kit_log_fn fn, kit_log_event* ev, void* udata, const char* fmt, ...) {
     ev->udata = udata;
+    ev->fmt = fmt;
+    va_start(ev->ap, fmt);
+    fn(ev);
+    va_end(ev->ap);
 }
 
+#define FIELDS_DROPPED_KEY "fields_dropped"
+#define FIELDS_DROPPED_SIZE (1 + sizeof(FIELDS_DROPPED_KEY) + 8)
 
-void kit_log(kit_log_level level, const char* file, int line, const char *fmt, ...) {
+//fields are packed after the message as type, key and value, strings with their terminator.
+//string values are cut to fit, fields that still don't fit are counted in a last fields_dropped field.
+static uint16_t _pack_fields(char* out, size_t cap, const kit_log_field* fields, int count) {
+    size_t pos = 0;
+    uint16_t packed = 0;
+    int i = 0;
+    for (; i < count; i++) {
+        //room for the marker is kept unless this is the last field
+        bool last = i + 1 == count;
+        size_t reserve = last ? 0 : FIELDS_DROPPED_SIZE;
+        if (packed == MAX_FIELDS - (last ? 0 : 1) || pos + reserve >= cap) break;
+        size_t room = cap - pos - reserve;
+
+        const kit_log_field* field = &fields[i];
+        size_t key_len = strlen(field->key) + 1;
+        const char* str = field->s ? field->s : "";
+        size_t value_len = field->type == KIT_LOG_FIELD_STRING ? strlen(str) + 1 :
+            field->type == KIT_LOG_FIELD_BOOL ? 1 : 8;
+        if (1 + key_len + value_len > room) {
+            if (field->type != KIT_LOG_FIELD_STRING || 1 + key_len + 1 > room) break;
+            value_len = room - 1 - key_len;
+        }
+        out[pos++] = (char)field->type;
+        memcpy(out + pos, field->key, key_len);
+        pos += key_len;
+        switch (field->type) {
+        case KIT_LOG_FIELD_INT:    memcpy(out + pos, &field->i, 8); break;
+        case KIT_LOG_FIELD_FLOAT:  memcpy(out + pos, &field->f, 8); break;
+        case KIT_LOG_FIELD_BOOL:   out[pos] = (char)field->b; break;
+        case KIT_LOG_FIELD_STRING:
+            memcpy(out + pos, str, value_len - 1);
+            out[pos + value_len - 1] = '\0';
+            break;
+        }
+        pos += value_len;
+        packed++;
+    }
+
+    if (i < count && pos + FIELDS_DROPPED_SIZE <= cap) {
+        int64_t dropped = count - i;
+        out[pos++] = (char)KIT_LOG_FIELD_INT;
+        memcpy(out + pos, FIELDS_DROPPED_KEY, sizeof(FIELDS_DROPPED_KEY));
+        pos += sizeof(FIELDS_DROPPED_KEY);
+        memcpy(out + pos, &dropped, 8);
+        packed++;
+    }
+    return packed;
+}
+
+static void _unpack_fields(const char* in, kit_log_field* fields, int count) {
+    for (int i = 0; i < count; i++) {
+        kit_log_field* field = &fields[i];
+        field->type = (kit_log_field_type)*in++;
+        field->key = in;
+        in += strlen(in) + 1;
+        switch (field->type) {
+        case KIT_LOG_FIELD_INT:    memcpy(&field->i, in, 8); in += 8; break;
+        case KIT_LOG_FIELD_FLOAT:  memcpy(&field->f, in, 8); in += 8; break;
+        case KIT_LOG_FIELD_BOOL:   field->b = *in++ != 0; break;
+        case KIT_LOG_FIELD_STRING: field->s = in; in += strlen(in) + 1; break;
+        }
+    }
+}
+
+static void _write_record(uint64_t seq, kit_log_level level, const char* file, int line, time_t t, uint64_t time_ns,
+    const char* msg, const kit_log_field* fields, int field_count) {
+    const _kit_log_clock* clock = _log_clock_at(t);
     kit_log_event ev = {
-        .fmt   = fmt,
-        .file  = file,
-        .line  = line,
-        .level = level,
+        .file        = file,
+        .line        = line,
+        .level       = level,
+        .time        = (struct tm*)&clock->tm,
+        .timestamp   = clock->timestamp,
+        .time_ns     = time_ns,
+        .seq         = seq,
+        .fields      = fields,
+        .field_count = field_count,
+    };
+    if (!_kit_logger.quiet && level >= _kit_logger.level) {
+        _dispatch(_stdout_callback, &ev, stderr, "%s", msg);
+    }
+    for (int i = 0; i < MAX_CALLBACKS && _kit_logger.callbacks[i].fn; i++) {
+        _kit_log_callback* cb = &_kit_logger.callbacks[i];
+        if (level >= cb->level) _dispatch(cb->fn, &ev, cb->udata, "%s", msg);
+    }
+}
+
+static int _ring_drain(_kit_log_ring* ring) {
+    int count = 0;
+    _lock();
+    _kit_logger.batching = true;
+
+    for (;;) {
+        _kit_log_record* rec = &ring->records[ring->head & ring->mask];
+        if (_kit_atomic_load_u64(&rec->seq) != ring->head + 1) break;
+        kit_log_field fields[MAX_FIELDS];
+        _unpack_fields(rec->msg + rec->fields_offset, fields, rec->field_count);
+        _write_record(rec->order, rec->level, rec->file, rec->line, rec->time, rec->time_ns, rec->msg, fields, rec->field_count);
+        _kit_atomic_store_u64(&rec->seq, ring->head + ring->mask + 1);
+        ring->head++;
+        count++;
+    }
+
+    uint64_t dropped = _kit_atomic_load_u64(&ring->dropped);
+    if (dropped) {
+        _kit_atomic_add_u64(&ring->dropped, (uint64_t)0 - dropped);
+        char msg[64];
+        snprintf(msg, sizeof(msg), "Log ring full, dropped %llu messages", (unsigned long long)dropped);
+        uint64_t time_ns = 0;
+        time_t t = _log_clock_now(&time_ns)->second;
+        _write_record(_kit_atomic_add_u64(&_kit_log_seq, 1), KIT_LOG_WARN, __FILE__, __LINE__, t, time_ns, msg, NULL, 0);
+        count++;
+    }
+
+    if (count) {
+        fflush(stderr);
+        for (int i = 0; i < MAX_CALLBACKS && _kit_logger.callbacks[i].fn; i++) {
+            if (_kit_logger.callbacks[i].fn == _file_callback) fflush(_kit_logger.callbacks[i].udata);
+        }
+    }
+
+    _kit_logger.batching = false;
+    _unlock();
+    _kit_atomic_store_u64(&ring->written, ring->head);
+    if (_kit_atomic_load_u32(&ring->flush_waiters)) {
+        _kit_mutex_lock(&ring->mutex);
+        _kit_cond_broadcast(&ring->drained);
+        _kit_mutex_unlock(&ring->mutex);
+    }
+    return count;
+}
+
+static bool _ring_ready(_kit_log_ring* ring) {
+    _kit_log_record* rec = &ring->records[ring->head & ring->mask];
+    return _kit_atomic_load_u64(&rec->seq) == ring->head + 1 || _kit_atomic_load_u64(&ring->dropped) != 0;
+}
+
+//sleeping is set before the ring is checked again and a producer checks it after publishing,
+//so either the writer sees the record or the producer sees the writer asleep
+static void _ring_wake(_kit_log_ring* ring) {
+    if (!_kit_atomic_load_u32(&ring->sleeping)) return;
+    _kit_mutex_lock(&ring->mutex);
+    _kit_atomic_store_u32(&ring->sleeping, 0);
+    _kit_cond_signal(&ring->wake);
+    _kit_mutex_unlock(&ring->mutex);
+}
+
+static _KIT_THREAD_PROC(_log_writer) {
+    _kit_log_ring* ring = (_kit_log_ring*)arg;
+    _kit_log_is_writer = true;
+    for (;;) {
+        bool stop = _kit_atomic_load_u32(&ring->stop) != 0;
+        if (_ring_drain(ring) == 0) {
+            if (stop) break;
+            _kit_mutex_lock(&ring->mutex);
+            _kit_atomic_store_u32(&ring->sleeping, 1);
+            while (_kit_atomic_load_u32(&ring->sleeping) && !_ring_ready(ring) && !_kit_atomic_load_u32(&ring->stop)) {
+                _kit_cond_wait(&ring->wake, &ring->mutex);
+            }
+            _kit_atomic_store_u32(&ring->sleeping, 0);
+            _kit_mutex_unlock(&ring->mutex);
+        }
+    }
+    return 0;
+}
+
+static void _log_async(_kit_log_ring* ring, kit_log_level level, const char* file, int line,
+    const kit_log_field* fields, int field_count, const char* fmt, va_list ap) {
+    uint64_t pos = 0;
+    _kit_log_record* rec = _ring_claim(ring, &pos);
+    //the writer can't wait for itself, callbacks that log drop when the ring is full
+    while (!rec && ring->overflow == KIT_LOG_OVERFLOW_BLOCK && !_kit_log_is_writer) {
+        _kit_thread_yield();
+        rec = _ring_claim(ring, &pos);
+    }
+    if (!rec) {
+        _kit_atomic_add_u64(&ring->dropped_total, 1);
+        if (ring->overflow == KIT_LOG_OVERFLOW_COUNT) _kit_atomic_add_u64(&ring->dropped, 1);
+        return;
+    }
+
+    rec->order = _kit_atomic_add_u64(&_kit_log_seq, 1);
+    rec->time = _log_clock_now(&rec->time_ns)->second;
+    rec->file = file;
+    rec->line = line;
+    rec->level = level;
+    int len = vsnprintf(rec->msg, sizeof(rec->msg), fmt, ap);
+    if (len < 0) len = 0;
+    if (len > (int)sizeof(rec->msg) - 1) len = (int)sizeof(rec->msg) - 1;
+    //a long message leaves room to report dropped fields
+    if (field_count && len > (int)(sizeof(rec->msg) - 1 - FIELDS_DROPPED_SIZE)) {
+        len = (int)(sizeof(rec->msg) - 1 - FIELDS_DROPPED_SIZE);
+        rec->msg[len] = '\0';
+    }
+    rec->fields_offset = (uint16_t)(len + 1);
+    rec->field_count = _pack_fields(rec->msg + rec->fields_offset, sizeof(rec->msg) - rec->fields_offset, fields, field_count);
+    _kit_atomic_store_u64(&rec->seq, pos + 1);
+    _ring_wake(ring);
+}
+
+bool kit_log_start_async(kit_allocator* alloc, const kit_log_async_desc* desc) {
+    if (!alloc || !desc || _kit_logger.async) return false;
+
+    uint64_t capacity = 1;
+    while (capacity < KIT_DEF(desc->capacity, 1024)) capacity <<= 1;
+
+    _kit_log_ring* ring = (_kit_log_ring*)kit_alloc(alloc, sizeof(_kit_log_ring));
+    if (!ring) return false;
+    memset(ring, 0, sizeof(_kit_log_ring));
+    ring->records = (_kit_log_record*)kit_alloc(alloc, capacity * sizeof(_kit_log_record));
+    if (!ring->records) {
+        kit_free(alloc, ring);
+        return false;
+    }
+    ring->alloc = *alloc;
+    ring->mask = capacity - 1;
+    ring->overflow = desc->overflow;
+    for (uint64_t i = 0; i < capacity; i++) {
+        ring->records[i].seq = i;
+    }
+    _kit_mutex_init(&ring->mutex);
+    _kit_cond_init(&ring->wake);
+    _kit_cond_init(&ring->drained);
+
+    _kit_logger.async = ring;
+    if (!_kit_thread_start(&ring->thread, _log_writer, ring)) {
+        _kit_logger.async = NULL;
+        _kit_cond_destroy(&ring->drained);
+        _kit_cond_destroy(&ring->wake);
+        _kit_mutex_destroy(&ring->mutex);
+        kit_free(alloc, ring->records);
+        kit_free(alloc, ring);
+        kit_log_error("Failed to start the log writer thread!");
+        return false;
+    }
+    return true;
+}
+
+void kit_log_flush(void) {
+    if (_kit_binlog_state) _binlog_flush(_kit_binlog_state);
+    _kit_log_ring* ring = _kit_logger.async;
+    if (ring && !_kit_log_is_writer) {
+        uint64_t target = _kit_atomic_load_u64(&ring->tail);
+        _kit_mutex_lock(&ring->mutex);
+        _kit_atomic_add_u32(&ring->flush_waiters, 1);
+        while (_kit_atomic_load_u64(&ring->written) < target) _kit_cond_wait(&ring->drained, &ring->mutex);
+        _kit_atomic_add_u32(&ring->flush_waiters, (uint32_t)-1);
+        _kit_mutex_unlock(&ring->mutex);
+    }
+
+    if (_kit_logger.buffered) _buffer_flush_all(_kit_logger.buffered, 0);
+    if (!_kit_log_is_writer) _lock();
+    for (int i = 0; i < MAX_CALLBACKS && _kit_logger.callbacks[i].fn; i++) {
+        _kit_log_callback* cb = &_kit_logger.callbacks[i];
+        if (cb->fn == _file_callback || cb->fn == _json_callback) fflush(cb->udata);
+        else if (cb->fn == _ring_file_callback) _ring_file_sync(cb->udata);
+    }
+    if (!_kit_log_is_writer) _unlock();
+}
+
+void kit_log_stop_async(void) {
+    _kit_log_ring* ring = _kit_logger.async;
+    if (!ring) return;
+    _kit_mutex_lock(&ring->mutex);
+    _kit_atomic_store_u32(&ring->stop, 1);
+    _kit_cond_signal(&ring->wake);
+    _kit_mutex_unlock(&ring->mutex);
+    _kit_thread_join(ring->thread);
+    _kit_logger.async = NULL;
+    _kit_cond_destroy(&ring->drained);
+    _kit_cond_destroy(&ring->wake);
+    _kit_mutex_destroy(&ring->mutex);
+
+    kit_allocator alloc = ring->alloc;
+    kit_free(&alloc, ring->records);
+    kit_free(&alloc, ring);
+}
+
+uint64_t kit_log_dropped_count(void) {
+    _kit_log_ring* ring = _kit_logger.async;
+    return ring ? _kit_atomic_load_u64(&ring->dropped_total) : 0;
+}
+
+static void _log_binary_fmt(_kit_binlog* log, kit_log_level level, const char* file, int line, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    _log_binary(log, level, file, line, fmt, ap);
+    va_end(ap);
+}
+
+static void _log_va(kit_log_level level, const char* file, int line,
+    const kit_log_field* fields, int field_count, const char* fmt, va_list ap) {
+    _kit_binlog* binlog = _kit_binlog_state;
+    if (binlog) {
+        bool logged = false;
+        if (level >= binlog->level && !field_count) {
+            va_list copy;
+            va_copy(copy, ap);
+            logged = _log_binary(binlog, level, file, line, fmt, copy);
+            va_end(copy);
+        }
+        if (level >= binlog->level && !logged) {
+            //fields and wide strings are rendered up front, the binary format only knows narrow printf arguments
+            char text[KIT_LOG_MESSAGE_SIZE * 4];
+            _log_line l = { text, sizeof(text), 0, NULL, false };
+            va_list copy;
+            va_copy(copy, ap);
+            _line_vprintf(&l, fmt, copy);
+            va_end(copy);
+            _line_fields(&l, fields, field_count);
+            _log_binary_fmt(binlog, level, file, line, "%s", text);
+        }
+        if (level < KIT_LOG_ERROR) return;
+    }
+
+    _kit_log_ring* ring = _kit_logger.async;
+    if (ring) {
+        if (!_log_wanted(level)) return;
+        va_list copy;
+        va_copy(copy, ap);
+        _log_async(ring, level, file, line, fields, field_count, fmt, copy);
+        va_end(copy);
+        if (level == KIT_LOG_FATAL) kit_log_flush();
+        return;
+    }
+
+    uint64_t time_ns = 0;
+    const _kit_log_clock* clock = _log_clock_now(&time_ns);
+    kit_log_event ev = {
+        .fmt         = fmt,
+        .file        = file,
+        .line        = line,
+        .level       = level,
+        .time        = (struct tm*)&clock->tm,
+        .timestamp   = clock->timestamp,
+        .time_ns     = time_ns,
+        .seq         = _kit_atomic_add_u64(&_kit_log_seq, 1),
+        .fields      = fields,
+        .field_count = field_count,
     };
 
     _lock();
 
     if (!_kit_logger.quiet && level >= _kit_logger.level) {
         _init_event(&ev, stderr);
-        va_start(ev.ap, fmt);
+        va_copy(ev.ap, ap);
         _stdout_callback(&ev);
         va_end(ev.ap);
     }
@@ -140,11 +1745,114 @@ void kit_log(kit_log_level level, const char* file, int line, const char *fmt, .
         _kit_log_callback* cb = &_kit_logger.callbacks[i];
         if (level >= cb->level) {
             _init_event(&ev, cb->udata);
-            va_start(ev.ap, fmt);
+            va_copy(ev.ap, ap);
             cb->fn(&ev);
             va_end(ev.ap);
         }
     }
 
+    if (level == KIT_LOG_FATAL && _kit_logger.buffered) _buffer_flush_all(_kit_logger.buffered, 0);
     _unlock();
-}
\ No newline at end of file
+}
+
+//LIMITS
+
+#define LOG_MAX_SITES 1024
+#define LOG_SITE_PROBES 16
+
+//state is the monotonic second in the upper 32 bits and the messages logged in it in the lower 32
+typedef struct {
+    volatile uint64_t key;
+    volatile uint64_t state;
+    volatile uint32_t suppressed;
+} _kit_log_site;
+
+static _kit_log_site _kit_log_sites[LOG_MAX_SITES];
+
+static uint64_t _site_key(const char* file, int line) {
+    uint64_t h = (uint64_t)(uintptr_t)file * 31 + (uint64_t)(uint32_t)line;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h ? h : 1;
+}
+
+//finds or claims the slot of a call site, NULL when the table is full
+static _kit_log_site* _site_get(const char* file, int line) {
+    uint64_t key = _site_key(file, line);
+    for (int probe = 0; probe < LOG_SITE_PROBES; probe++) {
+        _kit_log_site* site = &_kit_log_sites[(key + probe) % LOG_MAX_SITES];
+        uint64_t current = _kit_atomic_load_u64(&site->key);
+        if (current == key) return site;
+        if (current == 0) {
+            if (_kit_atomic_cas_u64(&site->key, &current, key) || current == key) return site;
+        }
+    }
+    return NULL;
+}
+
+//returns false if the message should be suppressed, otherwise how many were suppressed before it
+static bool _site_allow(_kit_log_site* site, uint32_t per_second, uint32_t* suppressed) {
+    uint64_t second = _kit_now_ns() / 1000000000ull;
+    uint64_t state = _kit_atomic_load_u64(&site->state);
+    for (;;) {
+        uint64_t next;
+        if (per_second == 0) {
+            if (state) break;
+            next = 1;
+        } else if ((state >> 32) != (second & 0xffffffffull)) {
+            next = (second << 32) | 1;
+        } else if ((uint32_t)state < per_second) {
+            next = state + 1;
+        } else {
+            break;
+        }
+        if (_kit_atomic_cas_u64(&site->state, &state, next)) {
+            uint32_t count = _kit_atomic_load_u32(&site->suppressed);
+            while (count && !_kit_atomic_cas_u32(&site->suppressed, &count, 0)) {}
+            *suppressed = count;
+            return true;
+        }
+    }
+    _kit_atomic_add_u32(&site->suppressed, 1);
+    return false;
+}
+
+void kit_log_limited(kit_log_level level, const char* file, int line, uint32_t per_second, const char* fmt, ...) {
+    if ((int)level < _kit_log_min_level) return;
+
+    uint32_t suppressed = 0;
+    _kit_log_site* site = _site_get(file, line);
+    //a full table logs everything rather than hiding messages
+    if (site && !_site_allow(site, per_second, &suppressed)) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    _log_va(level, file, line, NULL, 0, fmt, ap);
+    va_end(ap);
+    if (suppressed) kit_log(level, file, line, "Suppressed %u messages from this site", suppressed);
+}
+
+void kit_log(kit_log_level level, const char* file, int line, const char *fmt, ...) {
+    if ((int)level < _kit_log_min_level) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    _log_va(level, file, line, NULL, 0, fmt, ap);
+    va_end(ap);
+}
+
+static void _log_fields(kit_log_level level, const char* file, int line,
+    const kit_log_field* fields, int field_count, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    _log_va(level, file, line, fields, field_count, fmt, ap);
+    va_end(ap);
+}
+
+void kit_log_fields(kit_log_level level, const char* file, int line, const char* msg, const kit_log_field* fields, int field_count) {
+    if ((int)level < _kit_log_min_level) return;
+    _log_fields(level, file, line, fields, field_count, "%s", msg);
+}
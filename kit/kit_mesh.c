@@ -1,29 +1,77 @@
 #include "deps/bgfx/defines.h"
 #include "kit.h"
+#include "kit_internal.h"
 
 #define M3D_IMPLEMENTATION
 #include "deps/m3d.h"
 
 #include "deps/hashmap.h"
 
-kit_m3d_data* kit_load_m3d_data_mem(kit_memory* mem) {
-    if (!mem || mem->size == 0) return NULL;
+kit_m3d_data* kit_load_m3d_data_mem(kit_allocator* alloc, kit_memory* mem) {
+    if (!alloc || !mem || mem->size == 0) return NULL;
+    kit_allocator* prev = _kit_push_dep_allocator(alloc);
     kit_m3d_data* m3d = (kit_m3d_data*)m3d_load((unsigned char*)mem->ptr, NULL, NULL, NULL);
+    _kit_pop_dep_allocator(prev);
     return m3d;
 }
 
+//uncompressed models point into the file data, their mapping is kept until kit_release_m3d_data
+typedef struct _m3d_mapping {
+    struct _m3d_mapping* next;
+    kit_m3d_data* m3d;
+    kit_memory mem;
+} _m3d_mapping;
+
+static _m3d_mapping* _m3d_mappings;
+static volatile uint32_t _m3d_mappings_lock;
+
 kit_m3d_data* kit_load_m3d_data(kit_allocator* alloc, const char* path, kit_file_error* err) {
     if (!alloc || !path) return NULL;
-    kit_memory mem = kit_read_file(alloc, path, false, err);
+    kit_memory mem = kit_map_file(path, err);
     if (err && *err != KIT_FILE_ERROR_NONE) return NULL;
-    kit_m3d_data* m3d = kit_load_m3d_data_mem(&mem);
-    kit_free(alloc, mem.ptr);
+    kit_m3d_data* m3d = kit_load_m3d_data_mem(alloc, &mem);
+    //compressed models are inflated into a buffer m3d owns
+    if (!m3d || (m3d->flags & M3D_FLG_FREERAW)) {
+        kit_unmap_file(&mem);
+        return m3d;
+    }
+
+    _m3d_mapping* mapping = (_m3d_mapping*)kit_alloc(alloc, sizeof(_m3d_mapping));
+    if (!mapping) {
+        kit_release_m3d_data(alloc, m3d);
+        kit_unmap_file(&mem);
+        if (err) *err = KIT_FILE_ERROR_NOMEM;
+        return NULL;
+    }
+    mapping->m3d = m3d;
+    mapping->mem = mem;
+    _kit_spin_lock(&_m3d_mappings_lock);
+    mapping->next = _m3d_mappings;
+    _m3d_mappings = mapping;
+    _kit_spin_unlock(&_m3d_mappings_lock);
     return m3d;
 }
 
-void kit_release_m3d_data(kit_m3d_data* m3d) {
+void kit_release_m3d_data(kit_allocator* alloc, kit_m3d_data* m3d) {
     if (m3d) {
+        _m3d_mapping* mapping = NULL;
+        _kit_spin_lock(&_m3d_mappings_lock);
+        for (_m3d_mapping** it = &_m3d_mappings; *it; it = &(*it)->next) {
+            if ((*it)->m3d != m3d) continue;
+            mapping = *it;
+            *it = mapping->next;
+            break;
+        }
+        _kit_spin_unlock(&_m3d_mappings_lock);
+
+        kit_allocator* prev = _kit_push_dep_allocator(alloc);
         m3d_free(m3d);
+        _kit_pop_dep_allocator(prev);
+
+        if (mapping) {
+            kit_unmap_file(&mapping->mem);
+            kit_free_sized(alloc, mapping, sizeof(_m3d_mapping));
+        }
     }
 }
 
@@ -81,7 +129,9 @@ kit_mesh kit_make_mesh_from_m3d(kit_allocator* alloc, kit_m3d_data* m3d) {
 
     size_t key_size = has_skin ? sizeof(kit_vertex_skin) : sizeof(kit_vertex_pnt);
     hashmap_t map;
+    kit_allocator* prev_alloc = _kit_push_dep_allocator(alloc);
     hashmap_init(&map, key_size, sizeof(uint32_t), m3d->numface * 3, NULL, NULL);
+    _kit_pop_dep_allocator(prev_alloc);
 
     uint32_t unique_count = 0;
     uint32_t index_count = 0;
@@ -144,7 +194,7 @@ kit_mesh kit_make_mesh_from_m3d(kit_allocator* alloc, kit_m3d_data* m3d) {
             BGFX_BUFFER_INDEX32
         );
         mesh.element_count = index_count;
-        kit_free(alloc, skin_vertices);
+        kit_free_sized(alloc, skin_vertices, sizeof(kit_vertex_skin) * total_vertices);
     } else {
         layout = kit_vertex_layout_pnt();
         kit_vertex_pnt* pnt_vertices = (kit_vertex_pnt*)kit_alloc(alloc, sizeof(kit_vertex_pnt) * total_vertices);
@@ -186,11 +236,13 @@ kit_mesh kit_make_mesh_from_m3d(kit_allocator* alloc, kit_m3d_data* m3d) {
             BGFX_BUFFER_INDEX32
         );
         mesh.element_count = index_count;
-        kit_free(alloc, pnt_vertices);
+        kit_free_sized(alloc, pnt_vertices, sizeof(kit_vertex_pnt) * total_vertices);
     }
 
+    prev_alloc = _kit_push_dep_allocator(alloc);
     hashmap_free(&map);
-    kit_free(alloc, indices);
+    _kit_pop_dep_allocator(prev_alloc);
+    kit_free_sized(alloc, indices, sizeof(uint32_t) * total_vertices);
     return mesh;
 }
 
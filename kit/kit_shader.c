@@ -3,9 +3,9 @@
 
 bgfx_shader_handle_t kit_load_shader(kit_allocator *alloc, const char *path, kit_file_error *err) {
     if (!alloc || !path) return (bgfx_shader_handle_t)BGFX_INVALID_HANDLE;
-    kit_memory mem = kit_read_file(alloc, path, true, err);
+    kit_memory mem = kit_map_file(path, err);
     bgfx_shader_handle_t shader = kit_load_shader_mem(alloc, &mem);
-    kit_free(alloc, mem.ptr);
+    kit_unmap_file(&mem);
     return shader;
 }
 
@@ -1,4 +1,5 @@
 #include "kit_sound.h"
+#include "kit_internal.h"
 #define MINIAUDIO_IMPLEMENTATION
 #include "deps/miniaudio.h"
 
@@ -6,8 +7,32 @@
 typedef struct kit_audio_engine {
     ma_engine engine;
     kit_allocator allocator;
+    volatile uint32_t lock; //miniaudio allocates from its job and device threads too
 } kit_audio_engine;
 
+static void* _audio_malloc(size_t size, void* udata) {
+    kit_audio_engine* engine = (kit_audio_engine*)udata;
+    _kit_spin_lock(&engine->lock);
+    void* ptr = kit_alloc(&engine->allocator, size);
+    _kit_spin_unlock(&engine->lock);
+    return ptr;
+}
+
+static void* _audio_realloc(void* ptr, size_t size, void* udata) {
+    kit_audio_engine* engine = (kit_audio_engine*)udata;
+    _kit_spin_lock(&engine->lock);
+    ptr = kit_realloc(&engine->allocator, ptr, size);
+    _kit_spin_unlock(&engine->lock);
+    return ptr;
+}
+
+static void _audio_free(void* ptr, void* udata) {
+    kit_audio_engine* engine = (kit_audio_engine*)udata;
+    _kit_spin_lock(&engine->lock);
+    kit_free(&engine->allocator, ptr);
+    _kit_spin_unlock(&engine->lock);
+}
+
 kit_audio_engine* kit_create_audio_engine(kit_audio_engine_desc* desc) {
     kit_audio_engine* engine = (kit_audio_engine*)kit_alloc(&desc->allocator, sizeof(kit_audio_engine));
     if (!engine) {
@@ -15,9 +40,17 @@ kit_audio_engine* kit_create_audio_engine(kit_audio_engine_desc* desc) {
         return NULL;
     }
 
+    engine->allocator = desc->allocator;
+    engine->lock = 0;
+
     ma_engine_config config = ma_engine_config_init();
     config.sampleRate = desc->sample_rate;
     config.channels = desc->channel_count;
+    //miniaudio's allocations go through desc->allocator too, behind the engine's lock
+    config.allocationCallbacks.pUserData = engine;
+    config.allocationCallbacks.onMalloc = _audio_malloc;
+    config.allocationCallbacks.onRealloc = _audio_realloc;
+    config.allocationCallbacks.onFree = _audio_free;
 
     ma_result result = ma_engine_init(&config, &engine->engine);
     if (result != MA_SUCCESS) {
@@ -25,8 +58,6 @@ kit_audio_engine* kit_create_audio_engine(kit_audio_engine_desc* desc) {
         kit_free(&desc->allocator, engine);
         return NULL;
     }
-
-    engine->allocator = desc->allocator;
     return engine;
 }
 
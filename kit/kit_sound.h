@@ -5,6 +5,7 @@ typedef struct kit_audio_engine kit_audio_engine;
 typedef struct kit_sound { uint32_t id; } kit_sound;
 
 typedef struct kit_audio_engine_desc {
+    //also used by miniaudio's job and device threads, the engine serializes those calls with a lock
     kit_allocator allocator;
     int sample_rate;
     int channel_count;
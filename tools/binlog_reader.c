@@ -0,0 +1,27 @@
+//Renders a log written with kit_log_start_binary back to text.
+//
+//    sh ./build.bat tools/binlog_reader.c
+//    ./tools/binlog_reader <file.blog> [out.txt]
+
+#include "../kit/kit.h"
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <file.blog> [out.txt]\n", argv[0]);
+		return 1;
+	}
+
+	FILE* out = stdout;
+	if (argc > 2) {
+		out = fopen(argv[2], "w");
+		if (!out) {
+			kit_log_error("Failed to open %s", argv[2]);
+			return 1;
+		}
+	}
+
+	kit_allocator alloc = kit_default_allocator();
+	bool ok = kit_log_render_binary(&alloc, argv[1], out);
+	if (out != stdout) fclose(out);
+	return ok ? 0 : 1;
+}
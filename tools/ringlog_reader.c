@@ -0,0 +1,27 @@
+//Prints the lines that survived in a log ring file from kit_log_add_ring_file, oldest first.
+//
+//    sh ./build.bat tools/ringlog_reader.c
+//    ./tools/ringlog_reader <file.ring> [out.txt]
+
+#include "../kit/kit.h"
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <file.ring> [out.txt]\n", argv[0]);
+		return 1;
+	}
+
+	FILE* out = stdout;
+	if (argc > 2) {
+		out = fopen(argv[2], "w");
+		if (!out) {
+			kit_log_error("Failed to open %s", argv[2]);
+			return 1;
+		}
+	}
+
+	kit_allocator alloc = kit_default_allocator();
+	bool ok = kit_log_render_ring_file(&alloc, argv[1], out);
+	if (out != stdout) fclose(out);
+	return ok ? 0 : 1;
+}